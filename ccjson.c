@@ -37,9 +37,17 @@
 #include <time.h>
 #ifdef WIN32
 #   include <windows.h>
+#   include <intrin.h>
+#   include <io.h>
 #else
 #   include <sys/time.h>
 #   include <pthread.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#endif
+#if defined(__GLIBC__)
+#   include <malloc.h>
 #endif
 
 #include "ccjson.h"
@@ -176,10 +184,12 @@ CC_STATIC void dictRelease(dict *d);
 CC_STATIC dictEntry * dictFind(dict *d, const void *key);
 CC_STATIC void *dictFetchValue(dict *d, const void *key);
 CC_STATIC int dictResize(dict *d);
+#if 0 // the iterators are not used by ccjson
 CC_STATIC dictIterator *dictGetIterator(dict *d);
 CC_STATIC dictIterator *dictGetSafeIterator(dict *d);
 CC_STATIC dictEntry *dictNext(dictIterator *iter);
 CC_STATIC void dictReleaseIterator(dictIterator *iter);
+#endif
 CC_STATIC dictEntry *dictGetRandomKey(dict *d);
 CC_STATIC unsigned int dictGetSomeKeys(dict *d, dictEntry **des, unsigned int count);
 CC_STATIC void dictPrintStats(dict *d);
@@ -199,9 +209,93 @@ extern dictType dictTypeHeapStringCopyKey;
 extern dictType dictTypeHeapStrings;
 extern dictType dictTypeHeapStringCopyKeyValue;
 
-#define zmalloc malloc
-#define zcalloc(size) calloc(1, size)
-#define zfree free
+// the allocator backends ever installed, the memory records the index (owner) of its backend,
+// so it always goes back to the backend it came from; 0 is malloc and free
+#define __ccmembackendmax 16
+typedef struct __ccmembackend {
+    ccallocfunc alloc;
+    ccfreefunc free;
+    ccreallocfunc realloc;
+    void *user;
+}__ccmembackend;
+static __ccmembackend gmembackends[__ccmembackendmax] = {{NULL, NULL, NULL, NULL}};
+static int gmembackendcount = 1;
+// the backend of new allocs
+static volatile int gmembackend = 0;
+
+// alloc from backend owner
+static void *__ccbackendalloc(int owner, size_t size) {
+    if (owner) {
+        return gmembackends[owner].alloc(gmembackends[owner].user, size);
+    }
+    return malloc(size);
+}
+
+// free to backend owner
+static void __ccbackendfree(int owner, void *p) {
+    if (owner) {
+        gmembackends[owner].free(gmembackends[owner].user, p);
+        return;
+    }
+    free(p);
+}
+
+// realloc by backend owner, copy by hand if the backend have no realloc; NULL means failed and p is kept
+static void *__ccbackendrealloc(int owner, void *p, size_t oldsize, size_t size) {
+    void *n;
+    if (owner == 0) {
+        return realloc(p, size);
+    } else if (gmembackends[owner].realloc) {
+        return gmembackends[owner].realloc(gmembackends[owner].user, p, size);
+    }
+    n = gmembackends[owner].alloc(gmembackends[owner].user, size);
+    if (n) {
+        memcpy(n, p, oldsize < size ? oldsize : size);
+        gmembackends[owner].free(gmembackends[owner].user, p);
+    }
+    return n;
+}
+
+// the memory without the basic memory header (slabs, arena blocks, type metas, dicts, cJSON nodes)
+// keeps its owner in the word before it
+typedef union __ccsyshead {
+    int owner;
+    double align;
+}__ccsyshead;
+
+// alloc from current backend
+static void *__ccsysmalloc(size_t size) {
+    int owner = gmembackend;
+    __ccsyshead *head = (__ccsyshead*)__ccbackendalloc(owner, sizeof(__ccsyshead) + size);
+    if (head == NULL) {
+        return NULL;
+    }
+    head->owner = owner;
+    return head + 1;
+}
+
+// alloc from current backend and clear
+static void *__ccsyscalloc(size_t size) {
+    void *p = __ccsysmalloc(size);
+    if (p) {
+        memset(p, 0, size);
+    }
+    return p;
+}
+
+// free to the backend it came from
+static void __ccsysfree(void *p) {
+    __ccsyshead *head;
+    if (p == NULL) {
+        return;
+    }
+    head = (__ccsyshead*)p - 1;
+    __ccbackendfree(head->owner, head);
+}
+
+#define zmalloc __ccsysmalloc
+#define zcalloc __ccsyscalloc
+#define zfree __ccsysfree
 
 /* Using dictEnableResize() / dictDisableResize() we make possible to
  * enable/disable resizing of the hash table as needed. This is very important
@@ -670,6 +764,7 @@ CC_STATIC void *dictFetchValue(dict *d, const void *key) {
     return he ? dictGetVal(he) : NULL;
 }
 
+#if 0 // the iterators are not used by ccjson
 /* A fingerprint is a 64 bit number that represents the state of the dictionary
  * at a given time, it's just a few dict properties xored together.
  * When an unsafe iterator is initialized, we get the dict fingerprint, and check
@@ -773,6 +868,7 @@ CC_STATIC void dictReleaseIterator(dictIterator *iter)
     }
     zfree(iter);
 }
+#endif
 
 /* Return a random entry from the hash table. Useful to
  * implement randomized algorithms */
@@ -1308,6 +1404,7 @@ typedef struct cJSON {
     int type;                   /* The type of the item, as above. */
 
     char *valuestring;          /* The item's string, if type==cJSON_String */
+    const char *valuespan;      /* The raw text of string not decoded (streaming member), valueint64 is its length */
     int valueint;               /* The item's number, if type==cJSON_Number */
     ccint64 valueint64;         /* The item's number, if type==cJSON_Number */
     double valuedouble;         /* The item's number, if type==cJSON_Number */
@@ -1409,8 +1506,9 @@ static int cJSON_strcasecmp(const char *s1,const char *s2)
 	return tolower(*(const unsigned char *)s1) - tolower(*(const unsigned char *)s2);
 }
 
-static void *(*cJSON_malloc)(size_t sz) = malloc;
-static void (*cJSON_free)(void *ptr) = free;
+/* The nodes go to the allocator backend of library, see cc_set_allocator. */
+static void *(*cJSON_malloc)(size_t sz) = __ccsysmalloc;
+static void (*cJSON_free)(void *ptr) = __ccsysfree;
 
 static char* cJSON_strdup(const char* str)
 {
@@ -1426,13 +1524,13 @@ static char* cJSON_strdup(const char* str)
 void cJSON_InitHooks(cJSON_Hooks* hooks)
 {
     if (!hooks) { /* Reset hooks */
-        cJSON_malloc = malloc;
-        cJSON_free = free;
+        cJSON_malloc = __ccsysmalloc;
+        cJSON_free = __ccsysfree;
         return;
     }
 
-	cJSON_malloc = (hooks->malloc_fn)?hooks->malloc_fn:malloc;
-	cJSON_free	 = (hooks->free_fn)?hooks->free_fn:free;
+	cJSON_malloc = (hooks->malloc_fn)?hooks->malloc_fn:__ccsysmalloc;
+	cJSON_free	 = (hooks->free_fn)?hooks->free_fn:__ccsysfree;
 }
 
 /* Internal constructor. */
@@ -1525,18 +1623,11 @@ static unsigned parse_hex4(const char *str)
 
 /* Parse the input text into an unescaped cstring, and populate item. */
 static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
-static const char *parse_string(cJSON *item,const char *str)
+/* Unescape the string text from ptr until the closing quote, or until out has no room for one more char (outend, NULL means enough). */
+static const char *unescape_string(const char *ptr,char **pout,char *outend)
 {
-	const char *ptr=str+1;char *ptr2;char *out;int len=0;unsigned uc,uc2;
-	if (*str!='\"') {ep=str;return 0;}	/* not a string! */
-	
-	while (*ptr!='\"' && *ptr && ++len) if (*ptr++ == '\\') ptr++;	/* Skip escaped quotes. */
-	
-	out=(char*)cJSON_malloc(len+1);	/* This is how long we need for the string, roughly. */
-	if (!out) return 0;
-	
-	ptr=str+1;ptr2=out;
-	while (*ptr!='\"' && *ptr)
+	char *ptr2=*pout;int len;unsigned uc,uc2;
+	while (*ptr!='\"' && *ptr && (!outend || ptr2+4<=outend))
 	{
 		if (*ptr!='\\') *ptr2++=*ptr++;
 		else
@@ -1577,6 +1668,22 @@ static const char *parse_string(cJSON *item,const char *str)
 			ptr++;
 		}
 	}
+	*pout=ptr2;
+	return ptr;
+}
+
+static const char *parse_string(cJSON *item,const char *str)
+{
+	const char *ptr=str+1;char *ptr2;char *out;int len=0;
+	if (*str!='\"') {ep=str;return 0;}	/* not a string! */
+	
+	while (*ptr!='\"' && *ptr && ++len) if (*ptr++ == '\\') ptr++;	/* Skip escaped quotes. */
+	
+	out=(char*)cJSON_malloc(len+1);	/* This is how long we need for the string, roughly. */
+	if (!out) return 0;
+	
+	ptr2=out;
+	ptr=unescape_string(str+1,&ptr2,0);
 	*ptr2=0;
 	if (*ptr=='\"') ptr++;
 	item->valuestring=out;
@@ -1584,6 +1691,18 @@ static const char *parse_string(cJSON *item,const char *str)
 	return ptr;
 }
 
+/* Keep the string raw in the text without decoding, see ccparsefrom_opts. */
+static const char *parse_string_span(cJSON *item,const char *str)
+{
+	const char *ptr=str+1;
+	while (*ptr!='\"' && *ptr) if (*ptr++ == '\\' && *ptr) ptr++;	/* Skip escaped quotes. */
+	item->valuespan=str+1;
+	item->valueint64=ptr-(str+1);
+	item->type=cJSON_String;
+	if (*ptr=='\"') ptr++;
+	return ptr;
+}
+
 /* Render the cstring provided to an escaped version that can be printed. */
 static char *print_string_ptr(const char *str)
 {
@@ -1629,6 +1748,14 @@ static const char *parse_array(cJSON *item,const char *value);
 static char *print_array(cJSON *item,int depth,int fmt);
 static const char *parse_object(cJSON *item,const char *value);
 static char *print_object(cJSON *item,int depth,int fmt);
+static int __ccparsestreamkey(const char *key);
+
+/* The value of object member: the string of streaming member is kept raw in the text. */
+static const char *parse_member_value(cJSON *item,const char *value)
+{
+	if (*value=='\"' && __ccparsestreamkey(item->string)) return parse_string_span(item,value);
+	return parse_value(item,value);
+}
 
 /* Utility to jump whitespace and cr/lf */
 static const char *skip(const char *in) {while (in && *in && (unsigned char)*in<=32) in++; return in;}
@@ -1791,7 +1918,7 @@ static const char *parse_object(cJSON *item,const char *value)
 	if (!value) return 0;
 	child->string=child->valuestring;child->valuestring=0;
 	if (*value!=':') {ep=value;return 0;}	/* fail! */
-	value=skip(parse_value(child,skip(value+1)));	/* skip any spacing, get the value. */
+	value=skip(parse_member_value(child,skip(value+1)));	/* skip any spacing, get the value. */
 	if (!value) return 0;
 	
 	while (*value==',')
@@ -1803,7 +1930,7 @@ static const char *parse_object(cJSON *item,const char *value)
 		if (!value) return 0;
 		child->string=child->valuestring;child->valuestring=0;
 		if (*value!=':') {ep=value;return 0;}	/* fail! */
-		value=skip(parse_value(child,skip(value+1)));	/* skip any spacing, get the value. */
+		value=skip(parse_member_value(child,skip(value+1)));	/* skip any spacing, get the value. */
 		if (!value) return 0;
 	}
 	
@@ -2027,97 +2154,236 @@ ccint64 ccgetnextnano(){
 // memory tag: will set in basic json object header
 #define __CC_JSON_OBJ  1 
 #define __CC_JSON_ARRAY 1<<1
+// memory tag: the memory from arena
+#define __CC_ARENA 1<<2
 
 // ******************************************************************************
+#if CCCompactMemHeader
+// basic memory system object: one word of size and flags,
+// the link of free list lives in the payload of freed memory
+typedef struct __cc_content {
+    size_t word;    // size<<8 | owner<<4 | slab<<3 | flag
+
+    char content[];
+}__cc_content;
+
+// inherti the basic system object : like the array
+#define __internal_cc_content size_t word; char content[]
+
+// the bits of word, the owner bits are defined below
+#define __ccflagmask ((size_t)7)
+#define __ccslabbit ((size_t)8)
+#define __ccsizeshift 8
+
+// the fields of basic memory system object
+#define __cc_next(c) (*(struct __cc_content**)(c)->content)
+#define __cc_size(c) ((c)->word >> __ccsizeshift)
+#define __cc_setsize(c, s) ((c)->word = ((size_t)(s) << __ccsizeshift) | ((c)->word & (((size_t)1 << __ccsizeshift) - 1)))
+#define __cc_flags(c) ((c)->word)
+#define __cc_clearflags(c) ((c)->word &= ~__ccflagmask)
+// the slabs are aligned to the slab size, the chunk find its slab by address
+#define __cc_inslab(c) ((c)->word & __ccslabbit)
+#define __cc_slab(c) (__cc_inslab(c) ? (struct __ccmemslab*)((size_t)(c) & ~(size_t)(__ccslabsize-1)) : NULL)
+#define __cc_setslab(c, s) ((c)->word = (s) ? ((c)->word | __ccslabbit) : ((c)->word & ~__ccslabbit))
+// the payload should hold the link of free list
+#define __ccpayload(size) ((size)+1 > sizeof(void*) ? (size)+1 : sizeof(void*))
+#else
 // basic memory system object
 typedef struct __cc_content {
     size_t flag;
     size_t size;
     struct __cc_content *next;
-    struct __cc_content *pre;
+    void *slab;     // the slab holds this chunk, NULL means alloc from heap
 
     char content[];
 }__cc_content;
 
 // inherti the basic system object : like the array
-#define __internal_cc_content size_t flag; size_t size; struct __cc_content *next; struct __cc_content *pre; char content[]
+#define __internal_cc_content size_t flag; size_t size; struct __cc_content *next; void *slab; char content[]
+
+// the fields of basic memory system object
+#define __cc_next(c) ((c)->next)
+#define __cc_size(c) ((c)->size)
+#define __cc_setsize(c, s) ((c)->size = (s))
+#define __cc_flags(c) ((c)->flag)
+#define __cc_clearflags(c) ((c)->flag &= ~__ccflagmask)
+#define __cc_inslab(c) ((c)->slab != NULL)
+#define __cc_slab(c) ((struct __ccmemslab*)(c)->slab)
+#define __cc_setslab(c, s) ((c)->slab = (s))
+// the payload with the end 0
+#define __ccpayload(size) ((size)+1)
+// the flag bits, the owner bits are defined below
+#define __ccflagmask ((size_t)7)
+#endif
+
+// the backend (see gmembackends) of the memory from heap, bits 4-7 of the flags
+#define __ccownershift 4
+#define __ccownermask ((size_t)(__ccmembackendmax-1) << __ccownershift)
+#define __cc_owner(c) ((int)((__cc_flags(c) & __ccownermask) >> __ccownershift))
+#define __cc_setowner(c, o) (__cc_flags(c) = (__cc_flags(c) & ~__ccownermask) | ((size_t)(o) << __ccownershift))
+
+// the bytes of basic memory system object with size
+#define __ccchunkbytes(size) (sizeof(__cc_content) + __ccpayload(size))
+// the memory from arena
+#define __cc_inarena(c) (__cc_flags(c) & (__CC_ARENA))
 
 // make right basic memory system object pointer
 #define __to_content(p) (__cc_content*)((char*)p - sizeof(__cc_content))
 
-// statics about the memory state
+// statics about the memory state, updated by relaxed atomics without lock
 static size_t gmemalloc = 0;
 static size_t gmemfree = 0;
-static size_t gmemexpand = sizeof(__cc_content) + 1;
+static size_t gmempeak = 0;
+static size_t gmemalloccount = 0;
+static size_t gmemfreecount = 0;
+
+// relaxed atomics: the statics only need to be exact eventually
+#ifdef _MSC_VER
+#ifdef _WIN64
+#define __ccatomicadd(p, v) ((size_t)InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v)))
+#define __ccatomiccas(p, o, n) (InterlockedCompareExchange64((volatile LONG64*)(p), (LONG64)(n), (LONG64)(o)) == (LONG64)(o))
+#else
+#define __ccatomicadd(p, v) ((size_t)InterlockedExchangeAdd((volatile LONG*)(p), (LONG)(v)))
+#define __ccatomiccas(p, o, n) (InterlockedCompareExchange((volatile LONG*)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#endif
+#define __ccatomicload(p) (*(volatile size_t*)(p))
+#else
+#define __ccatomicadd(p, v) __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+#define __ccatomiccas(p, o, n) __atomic_compare_exchange_n(p, &(o), n, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define __ccatomicload(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#endif
 
-// keep the thred safe for memory system
+// define the getter of a recursive mutex, every system keeps its own
 #ifdef WIN32 
-static HANDLE _g_mem_mutex_get() {
-static HANDLE gmutex = 0;
-if (gmutex == 0) {
-    gmutex = CreateMutex(NULL, 0, NULL);
-}
-return gmutex;
-}
-#define __ccmemlock WaitForSingleObject(_g_mem_mutex_get(), 0)
-#define __ccmemunlock ReleaseMutex(_g_mem_mutex_get())
+#define __ccmutexdefine(getter) \
+static HANDLE getter() { \
+    static HANDLE gmutex = 0; \
+    if (gmutex == 0) { \
+        gmutex = CreateMutex(NULL, 0, NULL); \
+    } \
+    return gmutex; \
+}
+#define __ccmutexlock(getter) WaitForSingleObject(getter(), INFINITE)
+#define __ccmutexunlock(getter) ReleaseMutex(getter())
 #else
-static pthread_mutex_t *_g_mem_mutex_get() {
-static pthread_mutex_t mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER; 
-return &mutex;
+#define __ccmutexdefine(getter) \
+static pthread_mutex_t *getter() { \
+    static pthread_mutex_t mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER; \
+    return &mutex; \
 }
-#define __ccmemlock pthread_mutex_lock(_g_mem_mutex_get())
-#define __ccmemunlock pthread_mutex_unlock(_g_mem_mutex_get()) 
+#define __ccmutexlock(getter) pthread_mutex_lock(getter())
+#define __ccmutexunlock(getter) pthread_mutex_unlock(getter())
 #endif
 
-// print the memory states
-size_t cc_mem_state() {
-    size_t hold = 0;
-    __ccmemlock;
-    hold = gmemalloc-gmemfree; 
-    printf("[CCJSON-Memory] malloc: %ld, free: %ld, hold: %ld\n", 
-            gmemalloc, 
-            gmemfree, 
-            hold);
-    __ccmemunlock;
-
-    return hold;
-} 
+// keep the thred safe for memory system
+__ccmutexdefine(_g_mem_mutex_get)
+#define __ccmemlock __ccmutexlock(_g_mem_mutex_get)
+#define __ccmemunlock __ccmutexunlock(_g_mem_mutex_get)
 
 // get current memory useage total size
 size_t cc_mem_size() {
-    size_t hold = 0;
+    return __ccatomicload(&gmemalloc) - __ccatomicload(&gmemfree);
+}
 
-    __ccmemlock;
-    hold = gmemalloc-gmemfree; 
-    __ccmemunlock;
+// the peak of memory useage total size
+size_t cc_mem_peak() {
+    return __ccatomicload(&gmempeak);
+}
 
-    return hold;
+// the count of allocs from heap
+size_t cc_mem_alloccount() {
+    return __ccatomicload(&gmemalloccount);
 }
 
-// memory alloc
-static char *__cc_alloc(size_t size) {
-    __cc_content *content = (__cc_content*)calloc(1, size + gmemexpand);
-    content->size = size;
+// the count of frees to heap
+size_t cc_mem_freecount() {
+    return __ccatomicload(&gmemfreecount);
+}
 
-    __ccmemlock;
-    gmemalloc += (size + gmemexpand);
-    __ccmemunlock;
+// print the memory states
+size_t cc_mem_state() {
+    size_t alloc = __ccatomicload(&gmemalloc);
+    size_t freed = __ccatomicload(&gmemfree);
+    printf("[CCJSON-Memory] malloc: %ld, free: %ld, hold: %ld, peak: %ld, alloc count: %ld, free count: %ld\n", 
+            alloc, 
+            freed, 
+            alloc - freed,
+            cc_mem_peak(),
+            cc_mem_alloccount(),
+            cc_mem_freecount());
+    return alloc - freed;
+} 
+
+// raise the peak if current useage is higher
+static void __ccmempeak(size_t hold) {
+    size_t peak = __ccatomicload(&gmempeak);
+    while (hold > peak && !__ccatomiccas(&gmempeak, peak, hold)) {
+        peak = __ccatomicload(&gmempeak);
+    }
+}
+
+// memory alloc, the memory without zero only has the header and the end 0 set
+static char *__cc_alloc(size_t size, ccibool zero) {
+    __cc_content *content;
+    size_t alloc;
+    int owner = gmembackend;
+    content = (__cc_content*)__ccbackendalloc(owner, __ccchunkbytes(size));
+    // the custom backend may be full
+    cccheckret(content, NULL);
+    if (zero) {
+        memset(content, 0, __ccchunkbytes(size));
+    } else {
+        memset(content, 0, sizeof(__cc_content));
+        content->content[size] = 0;
+    }
+    __cc_setsize(content, size);
+    __cc_setowner(content, owner);
+
+    alloc = __ccatomicadd(&gmemalloc, __ccchunkbytes(size)) + __ccchunkbytes(size);
+    __ccatomicadd(&gmemalloccount, 1);
+    __ccmempeak(alloc - __ccatomicload(&gmemfree));
 
     return content->content;
 }
 
+// forward declare
+static void __ccmemslabfree(__cc_content *content);
+
 // memory free
 static void __cc_free(char *c) {
     __cc_content *content;
     cccheck(c);
     content = (__cc_content*)(c - sizeof(__cc_content));
+    // the chunk of slab goes back to slab
+    if (__cc_inslab(content)) {
+        __ccmemslabfree(content);
+        return;
+    }
 
-    __ccmemlock;
-    gmemfree += (content->size + gmemexpand); 
-    __ccmemunlock;
+    __ccatomicadd(&gmemfree, __ccchunkbytes(__cc_size(content)));
+    __ccatomicadd(&gmemfreecount, 1);
+
+    __ccbackendfree(__cc_owner(content), content);
+}
+
+// memory realloc of the block from heap by the backend it came from, the new bytes are not cleared;
+// NULL means failed and c is kept
+static char *__cc_realloc(char *c, size_t size) {
+    __cc_content *content = (__cc_content*)(c - sizeof(__cc_content));
+    size_t old = __cc_size(content);
+    size_t alloc;
 
-    free(content);
+    content = (__cc_content*)__ccbackendrealloc(__cc_owner(content), content, __ccchunkbytes(old), __ccchunkbytes(size));
+    cccheckret(content, NULL);
+    __cc_setsize(content, size);
+    content->content[size] = 0;
+
+    __ccatomicadd(&gmemfree, __ccchunkbytes(old));
+    __ccatomicadd(&gmemfreecount, 1);
+    alloc = __ccatomicadd(&gmemalloc, __ccchunkbytes(size)) + __ccchunkbytes(size);
+    __ccatomicadd(&gmemalloccount, 1);
+    __ccmempeak(alloc - __ccatomicload(&gmemfree));
+    return content->content;
 }
 
 // memory len 
@@ -2125,35 +2391,148 @@ static size_t __cc_len(char *c) {
     __cc_content *content;
     cccheckret(c, 0);
     content = (__cc_content*)(c - sizeof(__cc_content));
-    return content->size;
+    return __cc_size(content);
 }
 
 // set the memory object flag
 #define __cc_setflag(p, xflag)  do { \
     __cc_content *content = __to_content(p); \
-    if (content) { content->flag |= xflag; } \
+    if (content) { __cc_flags(content) |= (xflag); } \
     } while(0) 
 
 // judge the memory flag
-#define __cc_hasflag(p, xflag) (p && ((__to_content(p))->flag & xflag))
+#define __cc_hasflag(p, xflag) (p && (__cc_flags(__to_content(p)) & (xflag)))
 
 // clear the memory flag
 #define __cc_unsetflag(p, xflag)  do { \
     __cc_content *content = __to_content(p); \
-    if (content) { content->flag &= ~xflag; } \
+    if (content) { __cc_flags(content) &= ~(size_t)(xflag); } \
     } while(0) 
 
 // basic memory cache start size
 static const size_t __cc_isize = 4;
-// basic memory cache layer 
+// basic memory cache layer count: 4, 8, 12, 16, then four steps per power of two up to 32768
+#define __ccmemcachelayers 48
+// the request sizes resolved by table lookup, the larger ones by the highest bit
+#define __ccmemclasstable 4096
+// the slab: one large alloc split into the chunks of same size
+typedef struct __ccmemslab {
+    struct __ccmemslab *next;   // the slabs have available chunks
+    struct __ccmemslab *pre;
+    int index;
+    size_t count;               // the chunks in slab
+    size_t avail;               // the chunks in the free list of slab
+    __cc_content *base;         // the free list of slab
+}__ccmemslab;
+
+// the bytes of slab
+#define __ccslabsize (64*1024)
+// the size class use the slab only if the slab holds enough chunks
+#define __ccslabminchunks 8
+// the empty slabs kept by every size class, the more go back to system
+#define __ccslabwatermark 1
+
+#if CCCompactMemHeader
+// the slabs aligned to the slab size, the backend can not promise it, so no slab with backend
+#ifdef WIN32
+#define __ccslabmalloc() (gmembackend ? NULL : (__ccmemslab*)_aligned_malloc(__ccslabsize, __ccslabsize))
+#define __ccslabsysfree(slab) _aligned_free(slab)
+#else
+static __ccmemslab *__ccslabmalloc() {
+    void *slab = NULL;
+    cccheckret(gmembackend == 0, NULL);
+    return posix_memalign(&slab, __ccslabsize, __ccslabsize) == 0 ? (__ccmemslab*)slab : NULL;
+}
+#define __ccslabsysfree(slab) free(slab)
+#endif
+#else
+#define __ccslabmalloc() ((__ccmemslab*)__ccsysmalloc(__ccslabsize))
+#define __ccslabsysfree(slab) __ccsysfree(slab)
+#endif
+
+// basic memory cache layer: the depot shared by all threads
+// the counters of size class
+#define __ccmemhits 0       // the allocs served by the cached chunks
+#define __ccmemmisses 1     // the allocs go to slab or heap
+#define __ccmemoverflows 2  // the frees go to heap for the cache is full
+#define __ccmemcounters 3
+
+// the default capacity of size class, and the most it can adapt to
+#define __ccmemcapacitydefault 100
+#define __ccmemcapacitymax 8192
+// the operations counted before adapt the capacity once
+#define __ccmemadaptwindow 256
+
 struct {
     size_t size;
     size_t capacity;
     size_t len;
     __cc_content *base;
-}gmemcache[14]; // 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768
+    __ccmemslab *slabs;     // the slabs have available chunks
+    size_t emptyslabs;      // the slabs with all chunks available
+    size_t counters[__ccmemcounters];
+    size_t window[__ccmemcounters]; // the counters since last adapt
+    size_t lowwater;        // the least len since last trim, the chunks below it are idle
+    ccibool fixed;          // the capacity set by caller, not adapt
+}gmemcache[__ccmemcachelayers]; // 4, 8, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64, 80, ..., 28672, 32768
 // basic memory cache count
-static const int gmemcachecount = sizeof(gmemcache)/sizeof(gmemcache[0]);
+static const int gmemcachecount = __ccmemcachelayers;
+// the size class of request size, indexed by (size-1)/__cc_isize
+static unsigned char gmemclass[__ccmemclasstable/4];
+
+// the thread local memory cache: alloc and free without lock, exchange with the depot by batch
+typedef struct __ccmemtcache {
+    __cc_content *base[__ccmemcachelayers];
+    size_t len[__ccmemcachelayers];
+    __cc_content *reserve[__ccmemcachelayers]; // the fresh chunks taken from slabs
+    size_t counters[__ccmemcachelayers][__ccmemcounters]; // merged to the depot with lock
+    int registered;
+}__ccmemtcache;
+
+// the chunks exchanged with the depot once
+#define __ccmembatch 16
+
+#ifdef _MSC_VER
+#define __ccthreadlocal __declspec(thread)
+#else
+#define __ccthreadlocal __thread
+#endif
+static __ccthreadlocal __ccmemtcache gmemtcache;
+
+// the size of size class: 4, 8, 12, 16, then size/4 step in every power of two
+static size_t __ccmemclasssize(int index) {
+    size_t base;
+    if (index < 4) {
+        return __cc_isize*(index+1);
+    }
+    base = (__cc_isize*4)<<((index-4)/4);
+    return base + (base/4)*((index-4)%4+1);
+}
+
+// the highest bit of x, x should not be 0
+static int __cclog2(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (int)(sizeof(unsigned long long)*8-1) - __builtin_clzll((unsigned long long)x);
+#else
+    int i = 0;
+    while (x >>= 1) {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+// caculate the size class of size without the table
+static int __ccsizeclass(size_t size) {
+    int bit;
+    cccheckret(size, 0);
+    --size;
+    if (size < __cc_isize*4) {
+        return (int)(size/__cc_isize);
+    }
+    bit = __cclog2(size);
+    return 4 + 4*(bit-4) + (int)((size>>(bit-2))&3);
+}
 
 // init the memory cache
 static void __ccinitmemcache() {
@@ -2162,20 +2541,277 @@ static void __ccinitmemcache() {
     if (init) {
         return;
     }
-    ++init;
     __ccmemlock;
+    // the classes should be ready before any thread see the init
+    if (init) {
+        __ccmemunlock;
+        return;
+    }
+    for (i=0; i<(int)(sizeof(gmemclass)/sizeof(gmemclass[0])); ++i) {
+        gmemclass[i] = (unsigned char)__ccsizeclass((i+1)*__cc_isize);
+    }
     for (i=0; i<gmemcachecount; ++i) {
-        gmemcache[i].size = __cc_isize<<i;
-        gmemcache[i].capacity = 100;
+        gmemcache[i].size = __ccmemclasssize(i);
+        gmemcache[i].capacity = __ccmemcapacitydefault;
         gmemcache[i].len = 0;
         gmemcache[i].base = 0;
+        gmemcache[i].slabs = NULL;
+        gmemcache[i].emptyslabs = 0;
+        memset(gmemcache[i].counters, 0, sizeof(gmemcache[i].counters));
+        memset(gmemcache[i].window, 0, sizeof(gmemcache[i].window));
+        gmemcache[i].lowwater = 0;
+        gmemcache[i].fixed = ccino;
+    }
+    ++init;
+    __ccmemunlock;
+}
+
+// the stride of chunk in slab of size class, 0 means the size class not use slab
+static size_t __ccmemslabstride(int index) {
+    size_t stride = (__ccchunkbytes(gmemcache[index].size) + 15) & ~(size_t)15;
+    return (__ccslabsize - sizeof(__ccmemslab)) / stride >= __ccslabminchunks ? stride : 0;
+}
+
+// link the slab to the available slabs of size class, need lock
+static void __ccmemslablink(__ccmemslab *slab) {
+    slab->pre = NULL;
+    slab->next = gmemcache[slab->index].slabs;
+    if (slab->next) {
+        slab->next->pre = slab;
+    }
+    gmemcache[slab->index].slabs = slab;
+}
+
+// unlink the slab from the available slabs of size class, need lock
+static void __ccmemslabunlink(__ccmemslab *slab) {
+    if (slab->pre) {
+        slab->pre->next = slab->next;
+    } else {
+        gmemcache[slab->index].slabs = slab->next;
+    }
+    if (slab->next) {
+        slab->next->pre = slab->pre;
+    }
+    slab->next = slab->pre = NULL;
+}
+
+// give back the slab to system, need lock
+static void __ccmemslabrelease(__ccmemslab *slab) {
+    __ccmemslabunlink(slab);
+    --gmemcache[slab->index].emptyslabs;
+    __ccatomicadd(&gmemfree, __ccslabsize);
+    __ccatomicadd(&gmemfreecount, 1);
+    __ccslabsysfree(slab);
+}
+
+// put the chunk back to slab, the empty slabs beyond the watermark go back to system
+static void __ccmemslabfree(__cc_content *content) {
+    __ccmemslab *slab = __cc_slab(content);
+    __ccmemlock;
+    __cc_next(content) = slab->base;
+    slab->base = content;
+    if (slab->avail++ == 0) {
+        __ccmemslablink(slab);
+    }
+    if (slab->avail == slab->count) {
+        if (++gmemcache[slab->index].emptyslabs > __ccslabwatermark) {
+            __ccmemslabrelease(slab);
+        }
+    }
+    __ccmemunlock;
+}
+
+// give back all the empty slabs of size class to system
+static void __ccmemslabtrim(int index) {
+    __ccmemslab *slab, *next;
+    __ccmemlock;
+    for (slab = gmemcache[index].slabs; slab; slab = next) {
+        next = slab->next;
+        if (slab->avail == slab->count) {
+            __ccmemslabrelease(slab);
+        }
+    }
+    __ccmemunlock;
+}
+
+// take a batch of fresh chunks from slabs to the reserve of thread cache, alloc a slab if no one available
+static void __ccmemslabrefill(__ccmemtcache *tcache, int index) {
+    size_t stride = __ccmemslabstride(index);
+    __ccmemslab *slab;
+    __cc_content *content;
+    size_t i;
+    int n;
+    char *chunk;
+    cccheck(stride);
+
+    __ccmemlock;
+    slab = gmemcache[index].slabs;
+    if (slab == NULL) {
+        // split the new slab to chunks
+        slab = __ccslabmalloc();
+        if (slab == NULL) {
+            __ccmemunlock;
+            return;
+        }
+        __ccatomicadd(&gmemalloc, __ccslabsize);
+        __ccatomicadd(&gmemalloccount, 1);
+        __ccmempeak(__ccatomicload(&gmemalloc) - __ccatomicload(&gmemfree));
+
+        slab->index = index;
+        slab->count = (__ccslabsize - sizeof(__ccmemslab)) / stride;
+        slab->avail = slab->count;
+        slab->base = NULL;
+        chunk = (char*)slab + __ccslabsize - slab->count * stride;
+        for (i=0; i<slab->count; ++i, chunk += stride) {
+            content = (__cc_content*)chunk;
+            memset(content, 0, sizeof(__cc_content));
+            __cc_setsize(content, gmemcache[index].size);
+            __cc_setslab(content, slab);
+            __cc_next(content) = slab->base;
+            slab->base = content;
+        }
+        __ccmemslablink(slab);
+        ++gmemcache[index].emptyslabs;
+    }
+    if (slab->avail == slab->count) {
+        --gmemcache[index].emptyslabs;
+    }
+    for (n=0; n<__ccmembatch && slab->base; ++n) {
+        content = slab->base;
+        slab->base = __cc_next(content);
+        --slab->avail;
+        __cc_next(content) = tcache->reserve[index];
+        tcache->reserve[index] = content;
+    }
+    if (slab->avail == 0) {
+        __ccmemslabunlink(slab);
+    }
+    __ccmemunlock;
+}
+
+// give back the reserve of thread cache to slabs
+static void __ccmemreservefree(__ccmemtcache *tcache, int index) {
+    __cc_content *content;
+    while ((content = tcache->reserve[index])) {
+        tcache->reserve[index] = __cc_next(content);
+        __ccmemslabfree(content);
+    }
+}
+
+// adapt the capacity by the recent demand, need lock
+static void __ccmemadapt(int index) {
+    size_t *window = gmemcache[index].window;
+    size_t total = window[__ccmemhits] + window[__ccmemmisses] + window[__ccmemoverflows];
+    cccheck(total >= __ccmemadaptwindow);
+
+    // the allocs miss and the frees overflow both: the capacity is less than demand
+    if (!gmemcache[index].fixed
+        && window[__ccmemmisses]*8 >= total
+        && window[__ccmemoverflows]*8 >= total) {
+        gmemcache[index].capacity *= 2;
+        if (gmemcache[index].capacity > __ccmemcapacitymax) {
+            gmemcache[index].capacity = __ccmemcapacitymax;
+        }
+    }
+    memset(window, 0, sizeof(gmemcache[index].window));
+}
+
+// merge the counters of thread cache to the depot, need lock
+static void __ccmemtcachemerge(__ccmemtcache *tcache, int index) {
+    int i;
+    for (i=0; i<__ccmemcounters; ++i) {
+        gmemcache[index].counters[i] += tcache->counters[index][i];
+        gmemcache[index].window[i] += tcache->counters[index][i];
+        tcache->counters[index][i] = 0;
+    }
+    __ccmemadapt(index);
+}
+
+// move n chunks of thread cache to the depot, the chunks beyond the depot capacity go back to heap
+static void __ccmemtcacheflush(__ccmemtcache *tcache, int index, size_t n) {
+    __cc_content *content, *heap = NULL;
+    __ccmemlock;
+    __ccmemtcachemerge(tcache, index);
+    while (n-- && tcache->base[index]) {
+        content = tcache->base[index];
+        tcache->base[index] = __cc_next(content);
+        --tcache->len[index];
+        if (gmemcache[index].len < gmemcache[index].capacity) {
+            __cc_next(content) = gmemcache[index].base;
+            gmemcache[index].base = content;
+            ++gmemcache[index].len;
+        } else {
+            __cc_next(content) = heap;
+            heap = content;
+            ++gmemcache[index].counters[__ccmemoverflows];
+            ++gmemcache[index].window[__ccmemoverflows];
+        }
+    }
+    __ccmemunlock;
+
+    // free to heap without the cache lock
+    while (heap) {
+        content = heap;
+        heap = __cc_next(heap);
+        __cc_free(content->content);
+    }
+}
+
+// the thread exit: give back all the chunks of thread cache
+static void __ccmemtcacheexit(void *p) {
+    __ccmemtcache *tcache = (__ccmemtcache*)p;
+    int i;
+    for (i=0; i<gmemcachecount; ++i) {
+        __ccmemtcacheflush(tcache, i, tcache->len[i]);
+        __ccmemreservefree(tcache, i);
+    }
+    // register again if used by the later destructors
+    tcache->registered = 0;
+}
+
+#ifdef WIN32
+// the fiber local storage calls back when thread exit
+static DWORD gmemtcachekey = FLS_OUT_OF_INDEXES;
+static VOID WINAPI __ccmemtcacheflsexit(PVOID p) {
+    __ccmemtcacheexit(p);
+}
+static void __ccmemtcachekeyinit() {
+    __ccmemlock;
+    if (gmemtcachekey == FLS_OUT_OF_INDEXES) {
+        gmemtcachekey = FlsAlloc(__ccmemtcacheflsexit);
     }
     __ccmemunlock;
 }
+#else
+static pthread_key_t gmemtcachekey;
+static void __ccmemtcachekeyinit() {
+    pthread_key_create(&gmemtcachekey, __ccmemtcacheexit);
+}
+#endif
+
+// the memory cache of current thread
+static __ccmemtcache *__ccmemtcacheget() {
+#ifndef WIN32
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+#endif
+    __ccmemtcache *tcache = &gmemtcache;
+    if (!tcache->registered) {
+        tcache->registered = 1;
+#ifdef WIN32
+        __ccmemtcachekeyinit();
+        FlsSetValue(gmemtcachekey, tcache);
+#else
+        pthread_once(&once, __ccmemtcachekeyinit);
+        pthread_setspecific(gmemtcachekey, tcache);
+#endif
+    }
+    return tcache;
+}
 
 // print the memory state
 static size_t __ccmemcachestate() {
     size_t memsize = 0;
+    size_t current;
     int i;
 
     // init
@@ -2185,6 +2821,7 @@ static size_t __ccmemcachestate() {
             gmemcachecount);
     __ccmemlock;
     for (i=0; i<gmemcachecount; ++i) {
+        current = gmemcache[i].len + gmemtcache.len[i];
         printf("[CCJSON-Memory-Cache] ID: %d, "
                 "chuck size: %ld, "
                 "capacity: %ld, " 
@@ -2193,37 +2830,50 @@ static size_t __ccmemcachestate() {
                 i, 
                 gmemcache[i].size,
                 gmemcache[i].capacity,
-                gmemcache[i].len,
-                gmemcache[i].len * gmemcache[i].size);
-        memsize += gmemcache[i].len * gmemcache[i].size; 
+                current,
+                current * gmemcache[i].size);
+        memsize += current * gmemcache[i].size; 
     }
     __ccmemunlock;
     return memsize;
 }
 
-// print the memory states, and return the memory size hold by caches
+// print the memory states, and return the memory size hold by caches: the depot and this thread
 size_t cc_mem_cache_state() {
     return __ccmemcachestate();
 }
 
-// clear the memory cache of index
+// clear the memory cache of index: the depot and the cache of this thread, the caches of other threads are not touched
 void cc_mem_cache_clearof(int index) {
+    __cc_content *cache;
     // init the memory cache
     __ccinitmemcache();
     // check if the index is illege 
     cccheck(index>=0 && index<gmemcachecount);
 
+    // the current thread
+    while ((cache = gmemtcache.base[index])) {
+        gmemtcache.base[index] = __cc_next(cache);
+        __cc_free(cache->content);
+    }
+    gmemtcache.len[index] = 0;
+
     // free all memory cache with index
     __ccmemlock; 
+    gmemcache[index].lowwater = 0;
     while(gmemcache[index].base) {
-        __cc_content* cache = gmemcache[index].base; 
-        gmemcache[index].base = cache->next;
+        cache = gmemcache[index].base; 
+        gmemcache[index].base = __cc_next(cache);
         // 释放内存
         __cc_free(cache->content);
     }
     gmemcache[index].len = 0;
     gmemcache[index].base = NULL;
     __ccmemunlock;
+
+    // the fresh chunks of current thread, and the empty slabs
+    __ccmemreservefree(&gmemtcache, index);
+    __ccmemslabtrim(index);
 }
 
 // clear all memory cache
@@ -2234,10 +2884,14 @@ void cc_mem_cache_clear() {
     }
 }
 
-// get the memory cache unit size by index 
+// get the memory cache unit size by index: the depot and the cache of this thread
 size_t cc_mem_cache_current(int index) {
+    size_t len;
     cccheckret(index>=0 && index<gmemcachecount, 0);
-    return gmemcache[index].len;
+    __ccmemlock;
+    len = gmemcache[index].len;
+    __ccmemunlock;
+    return len + gmemtcache.len[index];
 }
 
 // get the memory cache capacity by index
@@ -2246,70 +2900,232 @@ size_t cc_mem_cache_capacity(int index) {
     return gmemcache[index].capacity; 
 }
 
-// set the memory capacity, set the capacity to 0 will disable the cache
+// set the memory capacity, set the capacity to 0 will disable the cache, the capacity will not adapt any more
 void cc_mem_cache_setcapacity(int index, size_t capacity) {
     cccheck(index>=0 && index<gmemcachecount);
     __ccmemlock;
     gmemcache[index].capacity = capacity;
+    gmemcache[index].fixed = cciyes;
     __ccmemunlock;
 }
 
-// 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096
-static int __ccsizeindex(size_t size) {
-    int index = 0;
-    cccheckret(size, 0);
-    size = (size-1)/__cc_isize;
-    while(size) {
-        ++index;
-        size = size >> 1;
-    }
-    return index;
+// the counter of size class: the depot and the cache of this thread
+static size_t __ccmemcounter(int index, int counter) {
+    size_t n;
+    cccheckret(index>=0 && index<gmemcachecount, 0);
+    __ccmemlock;
+    n = gmemcache[index].counters[counter];
+    __ccmemunlock;
+    return n + gmemtcache.counters[index][counter];
 }
 
-// get a basic memory object from memory cache
-static char* cc_mem_alloc(size_t size) {
-    int index;
-    __cc_content* cache;
-    char* mem;
+// get the allocs served by the memory cache of index
+size_t cc_mem_cache_hits(int index) {
+    return __ccmemcounter(index, __ccmemhits);
+}
 
-    // init the memory cache 
-    __ccinitmemcache();
-    // caculate the memory cache index
-    index = __ccsizeindex(size);
-    if (index < 0 || index >gmemcachecount) {
-        return __cc_alloc(size);
-    }
-    // if the memory cache have something
-    __ccmemlock; 
-    if (gmemcache[index].base) {
-        cache = gmemcache[index].base; 
+// get the allocs of index that the memory cache can not serve
+size_t cc_mem_cache_misses(int index) {
+    return __ccmemcounter(index, __ccmemmisses);
+}
 
-        gmemcache[index].base = cache->next;
-        --gmemcache[index].len;
+// get the frees of index go to heap for the memory cache is full
+size_t cc_mem_cache_overflows(int index) {
+    return __ccmemcounter(index, __ccmemoverflows);
+}
 
-        if (cache->next) {
-            cache->next->pre = NULL;
-            cache->next = NULL;
-        }
-        // clear memory
-        memset(cache->content, 0, size+1);
-        // clear flag
-        cache->flag = 0;
+// the snapshot of memory states as json (see ccmemstats), need cc_free;
+// the caches of other threads are only counted after they give back a batch to the depot
+char *cc_mem_stats_json() {
+    cctypemeta *meta = cctypeofmeta(ccmemstats);
+    cctypemeta *classmeta = cctypeofmeta(ccmemclass);
+    ccmemstats stats;
+    ccmemclass *classes, *c;
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0, NULL, 0};
+    size_t size;
+    char *json;
+    int i, m;
+
+    __ccinitmemcache();
+    ccinittypemeta(meta);
+    ccinittypemeta(classmeta);
+    classes = (ccmemclass*)ccarraymallocof(gmemcachecount, classmeta);
+
+    memset(&stats, 0, sizeof(stats));
+    stats.__index = meta->index;
+    stats.classes = classes;
+    __ccmemlock;
+    for (i=0; i<gmemcachecount; ++i) {
+        c = &classes[i];
+        c->__index = classmeta->index;
+        c->index = i;
+        c->size = (ccint64)gmemcache[i].size;
+        c->capacity = (ccint64)gmemcache[i].capacity;
+        c->current = (ccint64)(gmemcache[i].len + gmemtcache.len[i]);
+        c->hits = (ccint64)(gmemcache[i].counters[__ccmemhits] + gmemtcache.counters[i][__ccmemhits]);
+        c->misses = (ccint64)(gmemcache[i].counters[__ccmemmisses] + gmemtcache.counters[i][__ccmemmisses]);
+        c->overflows = (ccint64)(gmemcache[i].counters[__ccmemoverflows] + gmemtcache.counters[i][__ccmemoverflows]);
+        c->hold = c->current * c->size;
+        stats.hold += c->hold;
+        for (m=0; m<cctypeofmcount(ccmemclass); ++m) {
+            ccobjset(c, m);
+        }
+        ccarrayset(classes, i);
+    }
+    __ccmemunlock;
+    stats.size = (ccint64)cc_mem_size();
+    stats.peak = (ccint64)cc_mem_peak();
+    stats.alloccount = (ccint64)cc_mem_alloccount();
+    stats.freecount = (ccint64)cc_mem_freecount();
+    for (m=0; m<cctypeofmcount(ccmemstats); ++m) {
+        ccobjset(&stats, m);
+    }
+
+    // compact and exact size
+    size = ccunparse_size(meta, &stats, &opts);
+    json = cc_alloc_uninit(size);
+    ccunparse_tofixed(meta, &stats, json, size + 1, &opts);
+    ccobjrelease(meta, &stats);
+    return json;
+}
+
+// give back the idle cached chunks and the empty slabs to system, return the bytes released
+size_t cc_mem_trim() {
+    __cc_content *cache, *heap;
+    size_t before = cc_mem_size();
+    size_t after, n;
+    int i;
+
+    __ccinitmemcache();
+    for (i=0; i<gmemcachecount; ++i) {
+        heap = NULL;
+        __ccmemlock;
+        // the chunks below the low water are not used since last trim
+        n = gmemcache[i].lowwater;
+        while (n-- && gmemcache[i].base) {
+            cache = gmemcache[i].base;
+            gmemcache[i].base = __cc_next(cache);
+            --gmemcache[i].len;
+            __cc_next(cache) = heap;
+            heap = cache;
+        }
+        // the class have idle chunks, shrink the capacity back
+        if (heap && !gmemcache[i].fixed && gmemcache[i].capacity > __ccmemcapacitydefault) {
+            gmemcache[i].capacity /= 2;
+            if (gmemcache[i].capacity < __ccmemcapacitydefault) {
+                gmemcache[i].capacity = __ccmemcapacitydefault;
+            }
+        }
+        gmemcache[i].lowwater = gmemcache[i].len;
+        __ccmemunlock;
+
+        // free to heap without the cache lock
+        while (heap) {
+            cache = heap;
+            heap = __cc_next(heap);
+            __cc_free(cache->content);
+        }
+        __ccmemreservefree(&gmemtcache, i);
+        __ccmemslabtrim(i);
+    }
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+    after = cc_mem_size();
+    return before > after ? before - after : 0;
+}
+
+// the size class of size, return gmemcachecount when size is beyond all the classes
+static int __ccsizeindex(size_t size) {
+    cccheckret(size, 0);
+    if (size <= __ccmemclasstable) {
+        return gmemclass[(size-1)/__cc_isize];
+    }
+    if (size > gmemcache[gmemcachecount-1].size) {
+        return gmemcachecount;
+    }
+    return __ccsizeclass(size);
+}
+
+// get a basic memory object from memory cache
+static char* cc_mem_alloc(size_t size, ccibool zero) {
+    int index, n;
+    __ccmemtcache *tcache;
+    __cc_content* cache;
+    char* mem;
+
+    // init the memory cache 
+    __ccinitmemcache();
+    // caculate the memory cache index
+    index = __ccsizeindex(size);
+    if (index < 0 || index >= gmemcachecount) {
+        return __cc_alloc(size, zero);
+    }
+    tcache = __ccmemtcacheget();
+    // the thread cache is empty, refill a batch from the depot
+    if (tcache->base[index] == NULL && tcache->reserve[index] == NULL) {
+        __ccmemlock;
+        for (n=0; n<__ccmembatch && gmemcache[index].base; ++n) {
+            cache = gmemcache[index].base;
+            gmemcache[index].base = __cc_next(cache);
+            --gmemcache[index].len;
+
+            __cc_next(cache) = tcache->base[index];
+            tcache->base[index] = cache;
+            ++tcache->len[index];
+        }
+        if (gmemcache[index].len < gmemcache[index].lowwater) {
+            gmemcache[index].lowwater = gmemcache[index].len;
+        }
+        __ccmemtcachemerge(tcache, index);
+        __ccmemunlock;
+    }
+    // the fresh chunks from slab
+    if (tcache->base[index] == NULL && tcache->reserve[index] == NULL) {
+        __ccmemslabrefill(tcache, index);
+    }
+    if (tcache->base[index]) {
+        // if the memory cache have something
+        cache = tcache->base[index];
+        tcache->base[index] = __cc_next(cache);
+        --tcache->len[index];
+        ++tcache->counters[index][__ccmemhits];
+    } else {
+        ++tcache->counters[index][__ccmemmisses];
+        cache = tcache->reserve[index];
+        if (cache) {
+            tcache->reserve[index] = __cc_next(cache);
+        }
+    }
+    if (cache) {
+        __cc_next(cache) = NULL;
+
+        // clear memory
+        if (zero) {
+            memset(cache->content, 0, size+1);
+        } else {
+            cache->content[size] = 0;
+        }
+        // clear flag
+        __cc_clearflags(cache);
 
         // return
         mem = cache->content;
     } else {
         // the cache is empty, get one from the heap 
-        mem = __cc_alloc(gmemcache[index].size);
-        mem[size] = 0;
+        mem = __cc_alloc(gmemcache[index].size, zero);
+        if (mem) {
+            mem[size] = 0;
+        }
     }
-    __ccmemunlock;
 
     return mem;
 }
 
+// the memory can be freed on any thread, it goes to the cache of the freeing thread
 static void cc_mem_free(char *c) {
     __cc_content *content;
+    __ccmemtcache *tcache;
     int index;
 
     cccheck(c);
@@ -2317,40 +3133,200 @@ static void cc_mem_free(char *c) {
     __ccinitmemcache();
     // get the basic memery object pointer
     content = (__cc_content*)(c - sizeof(__cc_content));
-    index = __ccsizeindex(content->size);
-    if (index < 0 || index >gmemcachecount) {
+    index = __ccsizeindex(__cc_size(content));
+    // only the chunks of class size can go back to the cache
+    if (index < 0 || index >= gmemcachecount || __cc_size(content) != gmemcache[index].size) {
         __cc_free(c);
         return;
     }
-    // free basic memory object to cache
-    __ccmemlock; 
-    if (gmemcache[index].len < gmemcache[index].capacity) {
-        content->next = gmemcache[index].base;
-        if (content->next) {
-            content->next->pre = content;
-        }
-        content->pre = NULL;
-        content->flag = 0;
-
-        gmemcache[index].base = content;
-        ++gmemcache[index].len;
-    } else {
+    tcache = __ccmemtcacheget();
+    if (tcache->len[index] >= gmemcache[index].capacity) {
         // the cache is full, juse return to heap
+        ++tcache->counters[index][__ccmemoverflows];
         __cc_free(c);
+        return;
+    }
+    // free basic memory object to the thread cache
+    __cc_next(content) = tcache->base[index];
+    __cc_clearflags(content);
+    tcache->base[index] = content;
+    ++tcache->len[index];
+
+    // give back a batch to the depot
+    if (tcache->len[index] >= 2 * __ccmembatch) {
+        __ccmemtcacheflush(tcache, index, __ccmembatch);
     }
-    __ccmemunlock;
 }
 
 // the shuffter about the memory cache system
 ccibool ccenablememcache = cciyes;
 
+// ******************************************************************************
+// the block of arena
+typedef struct __ccarenablock {
+    struct __ccarenablock *next;
+    size_t size;        // the bytes of block with the header
+    ccibool mapped;     // the block from mmap with huge pages advised
+}__ccarenablock;
+
+// the header bytes of block, the allocs are 16 bytes aligned
+#define __ccarenaheader ((sizeof(__ccarenablock) + 15) & ~(size_t)15)
+// the default block size
+#define __ccarenablocksize (64*1024)
+#define __ccarenahugepagesize (2*1024*1024)
+
+// the arena of current thread parse
+static __ccthreadlocal ccarena *gmemarena = NULL;
+
+// alloc a block, from mmap with huge pages if the backend is not set
+static __ccarenablock *__ccarenablocknew(ccarena *arena, size_t size) {
+    __ccarenablock *block = NULL;
+    size_t alloc;
+#ifndef WIN32
+    void *p;
+    if (arena->hugepage && gmembackend == 0) {
+        p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+            madvise(p, size, MADV_HUGEPAGE);
+#endif
+            block = (__ccarenablock*)p;
+            block->mapped = cciyes;
+        }
+    }
+#endif
+    if (block == NULL) {
+        block = (__ccarenablock*)__ccsysmalloc(size);
+        cccheckret(block, NULL);
+        block->mapped = ccino;
+    }
+    block->next = NULL;
+    block->size = size;
+    arena->hold += size;
+
+    alloc = __ccatomicadd(&gmemalloc, size) + size;
+    __ccatomicadd(&gmemalloccount, 1);
+    __ccmempeak(alloc - __ccatomicload(&gmemfree));
+    return block;
+}
+
+// give back the block to system
+static void __ccarenablockfree(ccarena *arena, __ccarenablock *block) {
+    arena->hold -= block->size;
+    __ccatomicadd(&gmemfree, block->size);
+    __ccatomicadd(&gmemfreecount, 1);
+#ifndef WIN32
+    if (block->mapped) {
+        munmap(block, block->size);
+        return;
+    }
+#endif
+    __ccsysfree(block);
+}
+
+// bump bytes (16 bytes aligned) from arena
+static char *__ccarenabump(ccarena *arena, size_t bytes) {
+    __ccarenablock *block;
+    char *p;
+
+    // the large alloc get a block of its own
+    if (bytes > (arena->blocksize - __ccarenaheader) / 4) {
+        block = __ccarenablocknew(arena, __ccarenaheader + bytes);
+        cccheckret(block, NULL);
+        block->next = (__ccarenablock*)arena->large;
+        arena->large = block;
+        return (char*)block + __ccarenaheader;
+    }
+    if ((size_t)(arena->end - arena->cur) < bytes) {
+        // the next block kept from last reset, or a new one
+        block = arena->current ? ((__ccarenablock*)arena->current)->next : (__ccarenablock*)arena->blocks;
+        if (block == NULL) {
+            block = __ccarenablocknew(arena, arena->blocksize);
+            cccheckret(block, NULL);
+            if (arena->current) {
+                ((__ccarenablock*)arena->current)->next = block;
+            } else {
+                arena->blocks = block;
+            }
+        }
+        arena->current = block;
+        arena->cur = (char*)block + __ccarenaheader;
+        arena->end = (char*)block + block->size;
+    }
+    p = arena->cur;
+    arena->cur += bytes;
+    return p;
+}
+
+// alloc the basic memory object from arena
+static char *__ccarenaalloc(ccarena *arena, size_t size, ccibool zero) {
+    size_t bytes = (__ccchunkbytes(size) + 15) & ~(size_t)15;
+    __cc_content *content = (__cc_content*)__ccarenabump(arena, bytes);
+    cccheckret(content, NULL);
+
+    memset(content, 0, sizeof(__cc_content));
+    __cc_setsize(content, size);
+    __cc_flags(content) |= (__CC_ARENA);
+    if (zero) {
+        memset(content->content, 0, size+1);
+    } else {
+        content->content[size] = 0;
+    }
+    arena->used += bytes;
+    return content->content;
+}
+
+// init the arena, blocksize can be 0 (64KB, or 2MB with hugepage)
+void ccarenainit(ccarena *arena, size_t blocksize, ccibool hugepage) {
+    cccheck(arena);
+    memset(arena, 0, sizeof(ccarena));
+    if (blocksize == 0) {
+        blocksize = hugepage ? __ccarenahugepagesize : __ccarenablocksize;
+    }
+    // hold the header and some allocs at least
+    if (blocksize < 4096) {
+        blocksize = 4096;
+    }
+    arena->blocksize = blocksize;
+    arena->hugepage = hugepage;
+}
+
+// alloc from arena like cc_alloc (cleared, end with 0), cc_free on it does nothing
+char *ccarenaalloc(ccarena *arena, size_t size) {
+    cccheckret(arena, NULL);
+    return __ccarenaalloc(arena, size, cciyes);
+}
+
+// drop all the memory allocated from arena, keep the blocks for the next use
+void ccarenareset(ccarena *arena) {
+    __ccarenablock *block;
+    cccheck(arena);
+    while ((block = (__ccarenablock*)arena->large)) {
+        arena->large = block->next;
+        __ccarenablockfree(arena, block);
+    }
+    arena->current = NULL;
+    arena->cur = arena->end = NULL;
+    arena->used = 0;
+}
+
+// free all the blocks of arena
+void ccarenarelease(ccarena *arena) {
+    __ccarenablock *block;
+    cccheck(arena);
+    ccarenareset(arena);
+    while ((block = (__ccarenablock*)arena->blocks)) {
+        arena->blocks = block->next;
+        __ccarenablockfree(arena, block);
+    }
+}
+
 // enable and disable the memory cache system 
 ccibool cc_enablememorycache(ccibool enable) {
     ccibool ret = cciyes; 
     __ccmemlock;
     if (ccenablememcache != enable) {
         ccenablememcache = enable;
-        __ccmemunlock;
         ret = !ccenablememcache;
     } else {
         ret =  ccenablememcache;
@@ -2361,15 +3337,32 @@ ccibool cc_enablememorycache(ccibool enable) {
 
 // memory alloc, all memory will end with 0,  call cc_free to free
 char *cc_alloc(size_t size) {
-    if (ccenablememcache) {
-        return cc_mem_alloc(size);
+    if (gmemarena) {
+        return __ccarenaalloc(gmemarena, size, cciyes);
+    } else if (ccenablememcache) {
+        return cc_mem_alloc(size, cciyes);
+    }else {
+        return __cc_alloc(size, cciyes);
+    }
+}
+
+// memory alloc without clear, only the end 0 is set, call cc_free to free
+char *cc_alloc_uninit(size_t size) {
+    if (gmemarena) {
+        return __ccarenaalloc(gmemarena, size, ccino);
+    } else if (ccenablememcache) {
+        return cc_mem_alloc(size, ccino);
     }else {
-        return __cc_alloc(size);
+        return __cc_alloc(size, ccino);
     }
 }
 
 // free memory from cc_alloc
 void cc_free(char *c) {
+    // the memory from arena is released with the arena
+    if (c == NULL || __cc_inarena(__to_content(c))) {
+        return;
+    }
     if (ccenablememcache) {
         cc_mem_free(c);
     }else {
@@ -2377,6 +3370,37 @@ void cc_free(char *c) {
     }
 }
 
+// route the new memory of library to the backend, the memory alloced before still goes back to its own backend
+ccibool cc_set_allocator(ccallocfunc allocfunc, ccfreefunc freefunc, ccreallocfunc reallocfunc, void *user) {
+    int i, owner = 0;
+    __ccmemlock;
+    if (allocfunc && freefunc) {
+        // the same backend keeps the same owner
+        for (i=1; i<gmembackendcount; ++i) {
+            if (gmembackends[i].alloc == allocfunc && gmembackends[i].free == freefunc
+                    && gmembackends[i].realloc == reallocfunc && gmembackends[i].user == user) {
+                owner = i;
+                break;
+            }
+        }
+        if (owner == 0) {
+            if (gmembackendcount == __ccmembackendmax) {
+                __ccmemunlock;
+                return ccino;
+            }
+            owner = gmembackendcount;
+            gmembackends[owner].alloc = allocfunc;
+            gmembackends[owner].free = freefunc;
+            gmembackends[owner].realloc = reallocfunc;
+            gmembackends[owner].user = user;
+            ++gmembackendcount;
+        }
+    }
+    gmembackend = owner;
+    __ccmemunlock;
+    return cciyes;
+}
+
 // get the memory size(bytes)
 size_t cc_len(char *c) {
     return __cc_len(c);
@@ -2389,7 +3413,7 @@ char *cc_dup(const char* src) {
 
     cccheckret(src, NULL);
     len = strlen(src);
-    content = cc_alloc(len);
+    content = cc_alloc_uninit(len);
     memcpy(content, src, len);
     return content;
 }
@@ -2399,6 +3423,7 @@ char *cc_dup(const char* src) {
 char * cc_read_file(const char* fn) {
     char *content = NULL;
     size_t filesize = 0;
+    size_t read;
     FILE *file = 0;
 
     file = fopen(fn, "r");
@@ -2407,8 +3432,12 @@ char * cc_read_file(const char* fn) {
         filesize = ftell(file);
         rewind(file);
 
-        content = cc_alloc(filesize);
-        fread(content, 1, filesize, file);
+        content = cc_alloc_uninit(filesize);
+        read = fread(content, 1, filesize, file);
+        // the text mode may read less
+        if (read < filesize) {
+            memset(content + read, 0, filesize - read);
+        }
         fclose(file);
     }
     return content;
@@ -2425,6 +3454,83 @@ size_t cc_write_file(char* content, const char* fn) {
     return write;
 }
 
+// ******************************************************************************
+// init the buffer with capacity, capacity can be 0
+void ccbufferinit(ccbuffer *buffer, size_t capacity) {
+    cccheck(buffer);
+    buffer->data = NULL;
+    buffer->len = 0;
+    buffer->capacity = 0;
+    ccbufferreserve(buffer, capacity);
+}
+
+// make sure the buffer can hold capacity bytes
+void ccbufferreserve(ccbuffer *buffer, size_t capacity) {
+    char *data;
+    cccheck(buffer);
+    cccheck(capacity > buffer->capacity);
+
+    // the large buffer from heap grows in place if the allocator can
+    if (buffer->data && __ccsizeindex(buffer->capacity) >= gmemcachecount
+        && !__cc_inslab(__to_content(buffer->data))
+        && !__cc_inarena(__to_content(buffer->data))) {
+        // the buffer is kept if the backend failed
+        data = __cc_realloc(buffer->data, capacity);
+        cccheck(data);
+        buffer->data = data;
+        buffer->capacity = capacity;
+        return;
+    }
+    data = cc_alloc_uninit(capacity);
+    if (buffer->data) {
+        memcpy(data, buffer->data, buffer->len);
+        cc_free(buffer->data);
+    }
+    data[buffer->len] = 0;
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+// grow the buffer by double to hold n more bytes
+static void __ccbuffergrow(ccbuffer *buffer, size_t n) {
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < buffer->len + n) {
+        capacity <<= 1;
+    }
+    ccbufferreserve(buffer, capacity);
+}
+
+// append bytes to buffer
+void ccbufferappend(ccbuffer *buffer, const char *s, size_t n) {
+    cccheck(buffer && n);
+
+    if (buffer->len + n > buffer->capacity) {
+        __ccbuffergrow(buffer, n);
+        cccheck(buffer->len + n <= buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->len, s, n);
+    buffer->len += n;
+    buffer->data[buffer->len] = 0;
+}
+
+// set the len to 0, but keep the memory
+void ccbufferclear(ccbuffer *buffer) {
+    cccheck(buffer);
+    buffer->len = 0;
+    if (buffer->data) {
+        buffer->data[0] = 0;
+    }
+}
+
+// free the memory hold by buffer
+void ccbufferrelease(ccbuffer *buffer) {
+    cccheck(buffer);
+    cc_free(buffer->data);
+    buffer->data = NULL;
+    buffer->len = 0;
+    buffer->capacity = 0;
+}
+
 // ******************************************************************************
 // self define the dict
 /* ----------------------- StringCopy Hash Table Type ------------------------*/
@@ -2437,7 +3543,7 @@ static unsigned int _dictStringCopyHTHashFunction(const void *key)
 static void *_dictStringDup(void *privdata, const void *key)
 {
     size_t len = strlen((char*)key);
-    char *copy = (char*)malloc(len+1);
+    char *copy = (char*)__ccsysmalloc(len+1);
     DICT_NOTUSED(privdata);
     
     memcpy(copy, key, len);
@@ -2459,7 +3565,7 @@ static void _dictStringDestructor(void *privdata, void *key)
 {
     DICT_NOTUSED(privdata);
     
-    free(key);
+    __ccsysfree(key);
 }
 
 static dictType xdictTypeHeapStringCopyKey = {
@@ -2481,13 +3587,52 @@ static dictType xdictTypeHeapStringCopyKey = {
 typedef struct ccjson_obj {
     int __index;
     int __flag;
-    char __has[];
+    ccuint64 __has[];
 }ccjson_obj;
 
-// basic information: has
+// the words of has, null (and dirty) bits: {has, null, dirty} of every 64 members
+#define __cchasstride (2+CCDirtyMembers)
+#define __cchaswords(n) (__cchasstride*(((n)+63)/64))
+// the has word of member index
+#define __cchasword(obj, index) ((obj)->__has[__cchasstride*((index)>>6)])
+// the null word of member index
+#define __ccnullword(obj, index) ((obj)->__has[1+__cchasstride*((index)>>6)])
+#if CCDirtyMembers
+// the dirty word of member index
+#define __ccdirtyword(obj, index) ((obj)->__has[2+__cchasstride*((index)>>6)])
+// mark the member changed
+#define __ccsetdirty(obj, index) (__ccdirtyword(obj, index) |= __ccbit(index))
+#else
+#define __ccsetdirty(obj, index) ((void)0)
+#endif
+// the bit of member index in word
+#define __ccbit(index) (((ccuint64)1)<<((index)&63))
+
+// count trailing zeros, x should not be 0
+static int __ccctz64(ccuint64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (int)i;
+#else
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+// basic information: has, 
+// index is the byte of {has byte, null byte} of every 8 members
 char ccjsonobjhas(void *obj, int index) {
     ccjson_obj *iobj = (ccjson_obj*)obj;
-    return iobj->__has[index]; 
+    int member = (index/2)*8;
+    ccuint64 word = (index & 1) ? __ccnullword(iobj, member) : __cchasword(iobj, member);
+    return (char)((word >> (member & 63)) & 0xff);
 }
 
 // basic information: index
@@ -2515,11 +3660,22 @@ typedef struct ccjsonarray {
 
 // array element basic json object 
 static ccjson_obj *_ccjsonobjallocdynamic(int index, size_t n) {
-    ccjson_obj *obj = (ccjson_obj*)cc_alloc( sizeof(ccjson_obj) + 2*(n + 7)/8);
+    ccjson_obj *obj = (ccjson_obj*)cc_alloc( sizeof(ccjson_obj) + __cchaswords(n)*sizeof(ccuint64));
     obj->__index = index;
     return obj;
 }
 
+// the array with elements not cleared, the caller should fill all the elements
+static void *__ccarraymallocuninit(size_t n, size_t size, int index) {
+    ccjsonarray * p = (ccjsonarray*)cc_alloc_uninit(n * size + sizeof(ccjsonarray));
+    memset(p, 0, sizeof(ccjsonarray));
+    p->n = n;
+    p->nsize = size;
+    p->obj0 = _ccjsonobjallocdynamic(index, n);
+    __cc_setflag(p->content, __CC_JSON_ARRAY);
+    return p->content;
+}
+
 /**
  */
 void * ccarraymalloc(size_t n, size_t size, int index) {
@@ -2584,24 +3740,9 @@ static struct cctypemeta *gtypemetas[CCMaxTypeCount];
 static int gtypemetascnt = 0;
 
 // keep thread safe for meta system
-#ifdef WIN32
-static HANDLE _g_meta_mutex_get() {
-static HANDLE gmutex = 0;
-if (gmutex == 0) {
-    gmutex = CreateMutex(NULL, 0, NULL);
-}
-return gmutex;
-}
-#define __ccmetalock WaitForSingleObject(_g_meta_mutex_get(), 0)
-#define __ccmetaunlock ReleaseMutex(_g_meta_mutex_get())
-#else
-static pthread_mutex_t *_g_meta_mutex_get() {
-static pthread_mutex_t gmetamutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
-return &gmetamutex;
-}
-#define __ccmetalock pthread_mutex_lock(_g_meta_mutex_get())
-#define __ccmetaunlock pthread_mutex_unlock(_g_meta_mutex_get())
-#endif
+__ccmutexdefine(_g_meta_mutex_get)
+#define __ccmetalock __ccmutexlock(_g_meta_mutex_get)
+#define __ccmetaunlock __ccmutexunlock(_g_meta_mutex_get)
 
 #define __ccobj(p) (ccjson_obj*)(p)
 
@@ -2625,11 +3766,22 @@ int ccobjmindex(struct cctypemeta *meta, const char* member) {
 struct ccmembermeta * ccobjmmetabyindex(struct cctypemeta *meta, int index) {
     int len;
     cccheckret(meta, NULL);
-    len = (int)ccarraylen(meta->members);
+    len = (int)ccarraylen(meta->indexmembers);
     cccheckret(index >=0 && index<len, NULL);
     return meta->indexmembers[index];
 }
 
+// set the element filter of array member
+ccibool ccsetmemberfilter(struct cctypemeta *meta, int index, const ccarrayfilter *filter) {
+    ccmembermeta *member;
+    cccheckret(meta, ccino);
+    ccinittypemeta(meta);
+    member = ccobjmmetabyindex(meta, index);
+    cccheckret(member && member->compose == enumflagcompose_array, ccino);
+    member->filter = filter;
+    return cciyes;
+}
+
 // get member count of type with the meta
 int ccobjmcount(struct cctypemeta *meta) {
     cccheckret(meta, 0);
@@ -2641,7 +3793,7 @@ int ccobjmcount(struct cctypemeta *meta) {
  */
 ccibool ccobjhas(void *p, int index) {
     ccjson_obj *obj = __ccobj(p);
-    return (obj->__has[2*(index/8)] & (1 << (index%8))) != 0;
+    return (__cchasword(obj, index) & __ccbit(index)) != 0;
 }
 
 /**
@@ -2649,22 +3801,25 @@ ccibool ccobjhas(void *p, int index) {
 void ccobjset(void *p, int index) {
     ccjson_obj *obj = __ccobj(p);
     // we got value
-    obj->__has[2*(index/8)] |= (1<<(index%8));
+    __cchasword(obj, index) |= __ccbit(index);
     // unset null flag
-    obj->__has[1+2*(index/8)] &= ~(1<<(index%8));
+    __ccnullword(obj, index) &= ~__ccbit(index);
+    // changed
+    __ccsetdirty(obj, index);
 }
 
 /**
  */
 void ccobjunset(void *p, int index) {
    ccjson_obj *obj = __ccobj(p);
-   obj->__has[2*(index/8)] &= ~(1<<(index%8));
+   __cchasword(obj, index) &= ~__ccbit(index);
+   __ccsetdirty(obj, index);
 }
 
 // the json object if null
 ccibool ccobjisnull(void *p, int index) {
     ccjson_obj *obj = __ccobj(p);
-    return (obj->__has[1+2*(index/8)] & (1 << (index%8))) != 0;
+    return (__ccnullword(obj, index) & __ccbit(index)) != 0;
 }
 
 /**
@@ -2672,16 +3827,40 @@ ccibool ccobjisnull(void *p, int index) {
 void ccobjsetnull(void *p, int index) {
     ccjson_obj *obj = __ccobj(p);
     // set null
-    obj->__has[1+2*(index/8)] |= (1<<(index%8));
+    __ccnullword(obj, index) |= __ccbit(index);
     // unset has flag
-    obj->__has[2*(index/8)] &= ~(1<<(index%8));
+    __cchasword(obj, index) &= ~__ccbit(index);
+    // changed
+    __ccsetdirty(obj, index);
 }
 
 /**
  * */
 void ccobjunsetnull(void *p, int index) {
    ccjson_obj *obj = __ccobj(p);
-   obj->__has[1+2*(index/8)] &= ~(1<<(index%8));
+   __ccnullword(obj, index) &= ~__ccbit(index);
+   __ccsetdirty(obj, index);
+}
+
+// if the member changed since last checkpoint
+ccibool ccobjisdirty(void *p, int index) {
+#if CCDirtyMembers
+    ccjson_obj *obj = __ccobj(p);
+    return (__ccdirtyword(obj, index) & __ccbit(index)) != 0;
+#else
+    cc_unused(p);
+    cc_unused(index);
+    return ccino;
+#endif
+}
+
+/**
+ * */
+void ccobjsetdirty(void *p, int index) {
+    ccjson_obj *obj = __ccobj(p);
+    cc_unused(obj);
+    cc_unused(index);
+    __ccsetdirty(obj, index);
 }
 
 // if the array have been filled the element at index
@@ -2746,6 +3925,118 @@ ccibool ccobjnullis(void *p) {
    return (obj->__flag & enumflagccjsonobj_null) != 0;
 }
 
+// member iterator: walk the members that have value in declaration order,
+// jump from one to the next by the has bits, no memory alloc
+typedef struct ccmemberiterator {
+    cctypemeta *meta;
+    ccjson_obj *obj;
+    const ccuint64 *mask;
+    ccibool withdirty;
+    int word;
+    int words;
+    ccuint64 bits;
+}ccmemberiterator;
+
+// the has (and dirty) bits of word masked by the member mask
+#if CCDirtyMembers
+#define __ccmemberiteratordirty(ite) ((ite)->withdirty ? __ccdirtyword((ite)->obj, (ite)->word*64) : 0)
+#else
+#define __ccmemberiteratordirty(ite) 0
+#endif
+#define __ccmemberiteratorbits(ite) ((__cchasword((ite)->obj, (ite)->word*64) | __ccmemberiteratordirty(ite)) & \
+        ((ite)->mask ? (ite)->mask[(ite)->word] : ~(ccuint64)0))
+
+// init the member iterator, mask can be NULL, withdirty will walk the dirty members too
+static void __ccmemberiteratorinit(ccmemberiterator *ite, cctypemeta *meta, void *value, const ccuint64 *mask, ccibool withdirty) {
+    ite->meta = meta;
+    ite->obj = __ccobj(value);
+    ite->mask = mask;
+    ite->withdirty = withdirty;
+    ite->word = 0;
+    ite->words = (meta->membercount + 63) / 64;
+    ite->bits = ite->words ? __ccmemberiteratorbits(ite) : 0;
+}
+
+// next member that have value (or dirty), return NULL if the end
+static ccmembermeta *__ccmemberiteratornext(ccmemberiterator *ite) {
+    ccmembermeta *member;
+    int index;
+    while (1) {
+        while (ite->bits == 0) {
+            if (++ite->word >= ite->words) {
+                return NULL;
+            }
+            ite->bits = __ccmemberiteratorbits(ite);
+        }
+        index = ite->word*64 + __ccctz64(ite->bits);
+        ite->bits &= ite->bits - 1;
+        if (index < ite->meta->membercount && (member = ite->meta->indexmembers[index])) {
+            return member;
+        }
+    }
+}
+
+// set the basic member value, mark dirty only if the value changed
+static ccibool __ccobjsetvalue(cctypemeta *meta, void *p, int index, const char *type, const void *v, size_t size) {
+    ccmembermeta *member;
+    char *value;
+
+    cccheckret(meta && p, ccino);
+    ccinittypemeta(meta);
+    member = ccobjmmetabyindex(meta, index);
+    cccheckret(member && member->compose == 0 && member->type && member->type->type == type, ccino);
+
+    value = (char*)p + member->offset;
+    if (!ccobjhas(p, index) || memcmp(value, v, size) != 0) {
+        memcpy(value, v, size);
+        ccobjset(p, index);
+    }
+    return cciyes;
+}
+
+// typed setter: bool
+ccibool ccobjsetbool(cctypemeta *meta, void *p, int index, ccbool v) {
+    v = v ? cciyes : ccino;
+    return __ccobjsetvalue(meta, p, index, cctypeofname(ccbool), &v, sizeof(v));
+}
+
+// typed setter: int
+ccibool ccobjsetint(cctypemeta *meta, void *p, int index, ccint v) {
+    return __ccobjsetvalue(meta, p, index, cctypeofname(ccint), &v, sizeof(v));
+}
+
+// typed setter: int64
+ccibool ccobjsetint64(cctypemeta *meta, void *p, int index, ccint64 v) {
+    return __ccobjsetvalue(meta, p, index, cctypeofname(ccint64), &v, sizeof(v));
+}
+
+// typed setter: number
+ccibool ccobjsetnumber(cctypemeta *meta, void *p, int index, ccnumber v) {
+    return __ccobjsetvalue(meta, p, index, cctypeofname(ccnumber), &v, sizeof(v));
+}
+
+// typed setter: string, the string will be copied by cc_dup, and the old one freed
+ccibool ccobjsetstring(cctypemeta *meta, void *p, int index, const char *v) {
+    ccmembermeta *member;
+    ccstring *s;
+
+    cccheckret(meta && p, ccino);
+    ccinittypemeta(meta);
+    member = ccobjmmetabyindex(meta, index);
+    cccheckret(member && member->compose == 0 && member->type && member->type->type == cctypeofname(ccstring), ccino);
+
+    s = (ccstring*)((char*)p + member->offset);
+    if (ccobjhas(p, index) && (*s == v || (*s && v && strcmp(*s, v) == 0))) {
+        return cciyes;
+    }
+    if (*s) {
+        cc_free(*s);
+    }
+    *s = cc_dup(v);
+    ccobjset(p, index);
+    return cciyes;
+}
+
 // init the type dict 
 dict *ccgetparsedict() {
     __ccmetalock;
@@ -2772,11 +4063,17 @@ int ccaddtypemeta(cctypemeta *meta) {
 }
 
 int ccinittypemeta(cctypemeta *meta) {
+    // the memories of type meta live with the process, never from the arena of parse
+    ccarena *arena = gmemarena;
+    int index;
+    gmemarena = NULL;
     if (meta->init) {
-        return meta->init(meta);
+        index = meta->init(meta);
+    } else {
+        index = ccaddtypemeta(meta);
     }
-    
-    return ccaddtypemeta(meta);
+    gmemarena = arena;
+    return index;
 }
 
 // make a dict
@@ -2797,6 +4094,9 @@ ccmembermeta *ccmakemember(const char* name, const char* type, int offset, int i
     return ccmakememberwithmeta(name, ccgettypemeta(type), offset, index, compose);
 }
 
+// forward declare
+static void __ccmakekey(ccmembermeta *member);
+
 ccmembermeta *ccmakememberwithmeta(const char* name,
                            cctypemeta* type, int offset,
                            int index,
@@ -2807,6 +4107,7 @@ ccmembermeta *ccmakememberwithmeta(const char* name,
     _member->offset = offset;
     _member->idx = index;
     _member->compose = compose;
+    __ccmakekey(_member);
     return _member;
     
 }
@@ -2839,11 +4140,49 @@ void ccaddmember(cctypemeta *meta, ccmembermeta *member) {
     if ((int)len > member->idx ) {
         meta->indexmembers[member->idx] = member;
     }
+    if (member->defaultvalue) {
+        ++meta->defaults;
+    }
+}
+
+// set the declared default to the members without value and not null, mark them has if mark,
+// deep goes into the sub objects embedded
+static void __ccobjapplydefaults(cctypemeta *meta, void *value, ccibool mark, ccibool deep) {
+    ccmembermeta *member;
+    char *mvalue;
+    int i;
+
+    cccheck(meta->indexmembers);
+    for (i=0; i<meta->membercount; ++i) {
+        member = meta->indexmembers[i];
+        if (member == NULL || member->type == NULL || member->compose) {
+            continue;
+        }
+        mvalue = (char*)value + member->offset;
+        if (member->defaultvalue) {
+            if (ccobjhas(value, member->idx) || ccobjisnull(value, member->idx)) {
+                continue;
+            }
+            if (member->type->type == cctypeofname(ccstring)) {
+                cc_free(*(ccstring*)mvalue);
+                *(ccstring*)mvalue = *(const ccstring*)member->defaultvalue ?
+                    cc_dup(*(const ccstring*)member->defaultvalue) : NULL;
+            } else {
+                memcpy(mvalue, member->defaultvalue, member->type->size);
+            }
+            if (mark) {
+                ccobjset(value, member->idx);
+            }
+        } else if (deep && member->type->members) {
+            ccinittypemeta(member->type);
+            __ccobjapplydefaults(member->type, mvalue, mark, deep);
+        }
+    }
 }
 
 // make a type meta object
 cctypemeta *ccmaketypemeta(const char* type, size_t size) {
-    cctypemeta* meta = (cctypemeta*)calloc(1, sizeof(cctypemeta));
+    cctypemeta* meta = (cctypemeta*)__ccsyscalloc(sizeof(cctypemeta));
     meta->size = size;
     meta->type = type;
     meta->members = NULL;
@@ -2870,35 +4209,172 @@ cctypemeta *ccgettypemetaof(int index) {
     return gtypemetas[index];
 }
 
-// serial the infromation from json , will fill all the data to value
-ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member) {
-    // 解析
-    ccibool has = ccino;
-    int i;
-    void **pointvalue;
-    int arraysize;
-    void **vv;
-    void *v;
-    cJSON* child;
+// the options of ccparsefrom_opts on this thread, only during the call
+static __ccthreadlocal const ccparseopts *gparseopts = NULL;
+
+// find the member meta by json key: the member name, or the member index if the indexkey option set,
+// member name can not start with digit, so the index key just be an array lookup without hashing
+static ccmembermeta *__ccmembermetaofkey(cctypemeta *meta, const char *key) {
     dictEntry *entry;
-    ccmembermeta *membermeta;
+    const char *c = key;
+    int index = 0;
 
-    cccheckret(meta, ccino);
-    cccheckret(json, ccino);
-    // be sure all the meta will be init before use
-    ccinittypemeta(meta);
-    // array require
-    if (member && member->compose == enumflagcompose_array 
-            && json->type != cJSON_Array) {
-        // so can not set the array be cJSON_NULL
-        return has;
-    }
-    // point require
-    if (member && member->compose == enumflagcompose_point ) {
-        pointvalue = (void**)value;
-        if (*pointvalue == NULL ) {
-            *pointvalue = cc_alloc(meta->size);
-            has = cciyes;
+    cccheckret(key, NULL);
+    if (gparseopts && gparseopts->indexkey && *c >= '0' && *c <= '9') {
+        // no leading zero, the same as the index written
+        cccheckret(*c != '0' || c[1] == 0, NULL);
+        for (; *c >= '0' && *c <= '9'; ++c) {
+            index = index * 10 + (*c - '0');
+            cccheckret(index <= meta->membercount, NULL);
+        }
+        cccheckret(*c == 0, NULL);
+        return ccobjmmetabyindex(meta, index);
+    }
+    entry = dictFind((dict*)meta->members, key);
+    return entry ? (ccmembermeta*)entry->v.val : NULL;
+}
+
+// the chunk size of streaming member
+#define __ccstreamchunk (64*1024)
+
+// the streaming hook bound to member, NULL if none
+static const ccstringstream *__ccstreamof(const ccstringstream *streams, int count, ccmembermeta *mmeta) {
+    int i;
+    for (i=0; i<count; ++i) {
+        if (ccobjmmetabyindex(streams[i].meta, streams[i].index) == mmeta) {
+            return streams + i;
+        }
+    }
+    return NULL;
+}
+
+// the key may be of the streaming member: keep the string raw in the cJSON tree
+static int __ccparsestreamkey(const char *key) {
+    const ccparseopts *opts = gparseopts;
+    int i;
+    // no stream, no lookup
+    cccheckret(opts && opts->streams && opts->streamcount > 0 && key, 0);
+    for (i=0; i<opts->streamcount; ++i) {
+        if (opts->streams[i].consume && __ccmembermetaofkey(opts->streams[i].meta, key)
+                == ccobjmmetabyindex(opts->streams[i].meta, opts->streams[i].index)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// decode the raw string kept in the cJSON tree to a new string
+static ccstring __ccspandup(cJSON *json) {
+    char *str = cc_alloc_uninit((size_t)json->valueint64 + 1);
+    char *out = str;
+    unescape_string(json->valuespan, &out, NULL);
+    *out = 0;
+    return str;
+}
+
+// feed the string to the streaming member in chunks, the raw string is decoded chunk by chunk
+static void __ccparsestream(const ccstringstream *stream, void *obj, cJSON *json) {
+    const char *str = json->valuestring;
+    size_t len = str ? strlen(str) : 0;
+    size_t n;
+    char *chunk, *out;
+    if (json->valuespan) {
+        chunk = cc_alloc_uninit(__ccstreamchunk);
+        str = json->valuespan;
+        while (*str != '\"' && *str) {
+            out = chunk;
+            str = unescape_string(str, &out, chunk + __ccstreamchunk);
+            stream->consume(stream->ud, obj, chunk, (size_t)(out - chunk));
+        }
+        cc_free(chunk);
+        len = 0;
+    }
+    while (len) {
+        n = len < __ccstreamchunk ? len : __ccstreamchunk;
+        stream->consume(stream->ud, obj, str, n);
+        str += n;
+        len -= n;
+    }
+    stream->consume(stream->ud, obj, NULL, 0);
+}
+
+// forward declare
+ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member);
+
+// parse the array elements one by one to scratch, keep the accepted only, return the array of accepted
+static void *__ccparsefilter(cctypemeta *meta, cJSON *json, const ccarrayfilter *filter) {
+    ccbuffer kept, flags;
+    cJSON *child;
+    char *scratch;
+    char *v = NULL;
+    char flag;
+    int i, n;
+
+    ccbufferinit(&kept, 0);
+    ccbufferinit(&flags, 0);
+    scratch = cc_alloc(meta->size);
+    for (child = json->child; child; child = child->next) {
+        memset(scratch, 0, meta->size);
+        // flag: 1 has, 2 null
+        flag = ccparse(meta, scratch, child, NULL) ? 1 : 0;
+        flag |= child->type == cJSON_NULL ? 2 : 0;
+        // the element failed to parse is kept unset without asking, the same as no filter
+        if (flag == 0 || filter->accept(filter->ud, (flag & 2) ? NULL : scratch)) {
+            ccbufferappend(&kept, scratch, meta->size);
+            ccbufferappend(&flags, &flag, 1);
+        } else {
+            ccobjrelease(meta, scratch);
+        }
+    }
+    cc_free(scratch);
+
+    n = (int)flags.len;
+    if (n) {
+        v = (char*)__ccarraymallocuninit(n, meta->size, meta->index);
+        memcpy(v, kept.data, kept.len);
+        for (i=0; i<n; ++i) {
+            if (flags.data[i] & 1) {
+                ccarrayset(v, i);
+            }
+            if (flags.data[i] & 2) {
+                ccarraysetnull(v, i);
+            }
+        }
+    }
+    ccbufferrelease(&kept);
+    ccbufferrelease(&flags);
+    return v;
+}
+
+// serial the infromation from json , will fill all the data to value
+ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member) {
+    // 解析
+    ccibool has = ccino;
+    int i;
+    void **pointvalue;
+    int arraysize;
+    void **vv;
+    void *v;
+    cJSON* child;
+    ccmembermeta *membermeta;
+    const ccstringstream *stream;
+
+    cccheckret(meta, ccino);
+    cccheckret(json, ccino);
+    // be sure all the meta will be init before use
+    ccinittypemeta(meta);
+    // array require
+    if (member && member->compose == enumflagcompose_array 
+            && json->type != cJSON_Array) {
+        // so can not set the array be cJSON_NULL
+        return has;
+    }
+    // point require
+    if (member && member->compose == enumflagcompose_point ) {
+        pointvalue = (void**)value;
+        if (*pointvalue == NULL ) {
+            *pointvalue = cc_alloc(meta->size);
+            has = cciyes;
         }
         // deref
         value = *pointvalue;
@@ -2961,7 +4437,10 @@ ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member
             if (*(ccstring*)value) {
                 ccobjrelease(meta, value);
             }
-            if (json->valuestring) {
+            if (json->valuespan) {
+                // kept raw for the streaming member of the same key
+                *(ccstring*)value = __ccspandup(json);
+            } else if (json->valuestring) {
                 *(ccstring*)value = cc_dup(json->valuestring);
             } else {
                 *(ccstring*)value = NULL;
@@ -2978,12 +4457,16 @@ ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member
                 ccarrayfree(*vv);
                 *vv = NULL;
             }
-            if (arraysize) {
-                v = ccarraymalloc(arraysize, meta->size, meta->index);
+            if (arraysize && member->filter && member->filter->accept) {
+                *vv = __ccparsefilter(meta, json, member->filter);
+            } else if (arraysize) {
+                // clear the element just before parse, not a whole pass before
+                v = __ccarraymallocuninit(arraysize, meta->size, meta->index);
                 *vv = v;
                 child = NULL;
                 for (i=0; i<arraysize; ++i) {
                     child = cJSON_GetArrayItem(json, i);
+                    memset((char*)v + i * meta->size, 0, meta->size);
                     // should call ccparse first
                     if (ccparse(meta, (char*)v + i * meta->size, child, NULL)) {
                         ccarrayset(v, i);
@@ -3007,10 +4490,14 @@ ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member
             // set members
             child = json->child;
             while(child) {
-                entry= dictFind((dict*)meta->members, child->string);
-                if (entry) {
-                    membermeta = (ccmembermeta*)entry->v.val;
-                    
+                membermeta = __ccmembermetaofkey(meta, child->string);
+                stream = membermeta && gparseopts && child->type == cJSON_String ?
+                    __ccstreamof(gparseopts->streams, gparseopts->streamcount, membermeta) : NULL;
+                if (stream && stream->consume) {
+                    // streaming member
+                    __ccparsestream(stream, value, child);
+                    ccobjset(value, membermeta->idx);
+                } else if (membermeta) {
                     // should call ccparse first
                     if (ccparse(membermeta->type, (char*)value + membermeta->offset, child, membermeta)) {
                         ccobjset(value, membermeta->idx);
@@ -3022,6 +4509,11 @@ ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member
                 }
                 child = child->next;
             }
+            // the absent members take the declared default value but not has (the same as alloc),
+            // so the output omitting defaults reads back the same values
+            if (meta->defaults) {
+                __ccobjapplydefaults(meta, value, ccino, ccino);
+            }
             has = cciyes;
             break; }
     }
@@ -3029,147 +4521,23 @@ ccibool ccparse(cctypemeta *meta, void *value, cJSON *json, ccmembermeta *member
     return has;
 }
 
-// forward declare
-ccibool ccunparsemember(ccmembermeta *mmeta, void *value, struct cJSON *json);
-
-// unserial the json object to a json string, returned string neededcall cc_free to free the memory
-cJSON *ccunparse(cctypemeta *meta, void *value) {
-    cJSON *obj = NULL;
-    dictIterator *ite;
-    dictEntry *entry;
-    ccmembermeta* member;
-    ccbool *b;
-    ccint *i;
-    ccint64 *i64;
-    ccnumber *n;
-    ccstring *s;
-
-    // may be null
-    cccheckret(value, NULL);
-    // be sure all the meta will be init before use
-    ccinittypemeta(meta);
-    // unserial
-    if (meta->members) {
-        if (ccobjnullis(value) ) {
-            obj = cJSON_CreateNull();
-        } else {
-            obj = cJSON_CreateObject();
-            ite = dictGetIterator((dict*)meta->members);
-            entry = dictNext(ite);
-            while (entry) {
-                member = (ccmembermeta*)entry->v.val;
-                if (ccobjhas(value, member->idx)) {
-                    ccunparsemember(member, (char*)value + member->offset, obj);
-                }
-                entry = dictNext(ite);
-            }
-            dictReleaseIterator(ite);
-        }
-    } else if (meta->type == cctypeofname(ccbool)) {
-        b = (ccbool*)value;
-        obj = cJSON_CreateBool(*b);
-    } else if(meta->type == cctypeofname(ccint)) {
-        i = (ccint*)value;
-        obj = cJSON_CreateNumber(*i);
-    } else if (meta->type == cctypeofname(ccint64)) {
-        i64 = (ccint64*)value;
-        obj = cJSON_CreateNumber64(*i64);
-    } else if(meta->type == cctypeofname(ccnumber)) {
-        n = (ccnumber*)value;
-        obj = cJSON_CreateNumber(*n);
-    } else if(meta->type == cctypeofname(ccstring)) {
-        s = (ccstring *)value;
-        if(*s) {
-            obj = cJSON_CreateString(*s);
-        }else {
-            obj = cJSON_CreateNull();
-        }
-    } else {
-      // todo: @@
-    }
-    return obj;
-}
-
-// unserial a member
-ccibool ccunparsemember(ccmembermeta *mmeta, void *value, struct cJSON *json) {
-    cctypemeta *meta;
-
-    void **arrayvalue;
-    void *varray;
-    char *v;
-
-    int len;
-    int i;
-    cJSON *array;
-    cJSON * obj;
-
-    void** pointvalue;
-
-    cccheckret(mmeta, ccino);
-    cccheckret(json, ccino);
-    meta = mmeta->type;
-    cccheckret(meta, ccino);
-    // unparse
-    if (mmeta->compose == enumflagcompose_array) {
-        arrayvalue = (void**)value;
-        varray = *arrayvalue;
-        len = (int)ccarraylen(varray);
-        array = cJSON_CreateArray();
-        if (len) {
-            v = (char*)(varray);
-            for (i=0; i < len; ++i) {
-                obj = NULL;
-                // null
-                if (ccarrayisnull(varray, i)) {
-                    obj = cJSON_CreateNull();
-                }else if (ccarrayhas(varray, i) ) {
-                    obj = ccunparse(meta, v + i * meta->size);
-                }
-                if (obj) {
-                    cJSON_AddItemToArray(array, obj);
-                }
-            }
-        }
-        
-        cJSON_AddItemToObject(json, mmeta->name, array);
-    }else {
-        // if compose point need deref
-        if (mmeta->compose == enumflagcompose_point) {
-            pointvalue = (void**)value;
-            value = *pointvalue;
-        }
-        obj = ccunparse(meta, value);
-        if (obj) {
-            cJSON_AddItemToObject(json, mmeta->name, obj);
-        }
-    }
-    return cciyes;
-}
-
 // forward declare
 ccibool ccobjreleasemember(ccmembermeta *mmeta, void *value);
 
 // release the memory hold by p with type meta
 // the json object that have been called from ccparsefrom need call this to free memory 
 void ccobjrelease(cctypemeta *meta, void *value) {
-    dictIterator *ite;
-    dictEntry *entry;
+    ccmemberiterator ite;
     ccmembermeta* member;
     ccstring * s;
 
     // release
     if (meta->members) {
-        ite = dictGetIterator((dict*)meta->members);
-        entry = dictNext(ite);
-        while (entry) {
-            member = (ccmembermeta*)entry->v.val;
-            if (ccobjhas(value, member->idx)) {
-                ccobjreleasemember(member, (char*)value + member->offset);
-                ccobjunset(value, member->idx);
-            }
-            entry = dictNext(ite);
+        __ccmemberiteratorinit(&ite, meta, value, NULL, ccino);
+        while ((member = __ccmemberiteratornext(&ite))) {
+            ccobjreleasemember(member, (char*)value + member->offset);
+            ccobjunset(value, member->idx);
         }
-        dictReleaseIterator(ite);
     } else if (meta->type == cctypeofname(ccbool)) {
         //bool *b = (bool*)value;
     } else if(meta->type == cctypeofname(ccint)) {
@@ -3226,6 +4594,7 @@ ccibool ccobjreleasemember(ccmembermeta *mmeta, void *value) {
         if (mmeta->compose == enumflagcompose_point) {
             pointvalue = (void**)value;
             value = *pointvalue;
+            cccheckret(value, cciyes);
         }
         
         ccobjrelease(meta, value);
@@ -3248,91 +4617,1716 @@ ccibool ccparsefrom(cctypemeta *meta, void *value, const char *json) {
     return ok;
 }
 
-// unserial the json object to a json string, returned string neededcall cc_free to free the memory
-char *ccunparseto(cctypemeta *meta, void *value) {
-    char *str = NULL;
-    char *content = NULL;
-    cJSON *json = ccunparse(meta, value);
-    str = cJSON_Print(json);
-    cJSON_Delete(json);
-    content = cc_dup(str);
-    free(str);
-    return content;
+// parse with the options set on this thread during the call, so the cJSON parser and ccparse see them
+ccibool ccparsefrom_opts(cctypemeta *meta, void *value, const char *json, const ccparseopts *opts) {
+    const ccparseopts *old = gparseopts;
+    ccibool ok = ccino;
+    cJSON* cjson;
+    int i;
+    cccheckret(meta && json, ccino);
+    ccinittypemeta(meta);
+    for (i=0; opts && i<opts->streamcount; ++i) {
+        ccinittypemeta(opts->streams[i].meta);
+    }
+
+    gparseopts = opts;
+    cjson = cJSON_Parse(json);
+    ok = ccparse(meta, value, cjson, NULL);
+    cJSON_Delete(cjson);
+    gparseopts = old;
+    return ok;
 }
 
-// set the meta index in basic json object
-#define __cc_setmetaindex(p, index) do { \
-    ccjson_obj* obj = (ccjson_obj*)p; \
-    if(obj && obj->__index == index) { \
-        obj->__index = index; \
-    }} while(0)  
+// parse with all the memories of value from arena, the cJSON tree is freed before return so keep from heap
+ccibool ccparsefrom_arena(cctypemeta *meta, void *value, const char *json, ccarena *arena) {
+    ccarena *old = gmemarena;
+    ccibool ok = ccino;
+    cJSON* cjson;
+    cccheckret(arena, ccino);
 
-// ******************************************************************************
-// helper: malloc a basic json object with type meta, we can call the ccjsonobjfree to free memories
-void *ccjsonobjalloc(cctypemeta* meta) {
-    ccjson_obj *obj;
+    cjson = cJSON_Parse(json);
+    gmemarena = arena;
+    ok = ccparse(meta, value, cjson, NULL);
+    gmemarena = old;
+    cJSON_Delete(cjson);
+    return ok;
+}
+
+// merge patch the json object to value (RFC 7396)
+static ccibool __ccpatch(cctypemeta *meta, void *value, cJSON *json) {
+    cJSON *child;
+    ccmembermeta *member;
+    void *mvalue;
+
+    // not a object patch: replace the whole value
+    if (json->type != cJSON_Object || meta->members == NULL) {
+        return ccparse(meta, value, json, NULL);
+    }
+    ccobjnullset(value, ccino);
+    for (child = json->child; child; child = child->next) {
+        member = __ccmembermetaofkey(meta, child->string);
+        if (member == NULL || member->type == NULL) {
+            continue;
+        }
+        mvalue = (char*)value + member->offset;
+        if (child->type == cJSON_NULL) {
+            // remove the member, the absent one have nothing to release
+            if (ccobjhas(value, member->idx)) {
+                ccobjreleasemember(member, mvalue);
+                if (member->compose == 0 && member->type->members == NULL) {
+                    memset(mvalue, 0, member->type->size);
+                }
+            }
+            ccobjunset(value, member->idx);
+            ccobjunsetnull(value, member->idx);
+        } else if (child->type == cJSON_Object && member->compose != enumflagcompose_array
+                   && member->type->members) {
+            // patch the sub object in place
+            ccinittypemeta(member->type);
+            if (member->compose == enumflagcompose_point) {
+                if (*(void**)mvalue == NULL) {
+                    *(void**)mvalue = cc_alloc(member->type->size);
+                }
+                mvalue = *(void**)mvalue;
+            } else if (!ccobjhas(value, member->idx)) {
+                // the absent member patched as a new object
+                ccobjrelease(member->type, mvalue);
+            }
+            __ccpatch(member->type, mvalue, child);
+            ccobjset(value, member->idx);
+            ccobjunsetnull(value, member->idx);
+        } else if (ccparse(member->type, mvalue, child, member)) {
+            // replace
+            ccobjset(value, member->idx);
+            ccobjunsetnull(value, member->idx);
+        }
+    }
+    return cciyes;
+}
+
+// merge patch the json (RFC 7396) to value: the members in patch are replaced, null removes the member,
+// the object patch goes into sub object, all the other members are untouched
+ccibool ccpatchfrom(cctypemeta *meta, void *value, const char *json) {
+    ccibool ok = ccino;
+    cJSON* cjson;
+    cccheckret(meta && value && json, ccino);
     ccinittypemeta(meta);
+    cjson = cJSON_Parse(json);
+    cccheckret(cjson, ccino);
+    ok = __ccpatch(meta, value, cjson);
+    cJSON_Delete(cjson);
+    return ok;
+}
 
-    obj = (ccjson_obj*)cc_alloc(meta->size);
-    obj->__index = meta->index;
-    __cc_setflag(obj, __CC_JSON_OBJ);
-    return obj;
+// ******************************************************************************
+// writer: unserial the typed object to json text directly, without the cJSON tree
+// the output is the same as cJSON_Print (cJSON_PrintUnformatted with compact flag)
+typedef struct ccwriter {
+    ccbuffer *buffer;   // grow the buffer when out is full
+    char *out;          // NULL means only caculate the size
+    size_t capacity;    // the bytes can be written to out
+    size_t len;         // the bytes have been required by now
+    int fmt;            // format with new line and tabs
+    const ccunparseopts *opts;
+}ccwriter;
+
+// the writer can grow the out
+#define __ccwritercangrow(w) ((w)->buffer)
+
+// init the writer, out can be NULL
+static void __ccwriterinit(ccwriter *w, char *out, size_t capacity, const ccunparseopts *opts) {
+    w->buffer = NULL;
+    w->out = out;
+    w->capacity = capacity;
+    w->len = 0;
+    w->opts = opts;
+    w->fmt = !(opts && (opts->flag & enumflagccunparse_compact));
+}
+
+// init the writer to append the buffer
+static void __ccwriterinitbuffer(ccwriter *w, ccbuffer *buffer, const ccunparseopts *opts) {
+    __ccwriterinit(w, buffer->data, buffer->capacity, opts);
+    w->buffer = buffer;
+    w->len = buffer->len;
+}
+
+// grow the buffer to hold n more bytes
+static void __ccwritergrow(ccwriter *w, size_t n) {
+    w->buffer->len = w->len;
+    __ccbuffergrow(w->buffer, n);
+    w->out = w->buffer->data;
+    w->capacity = w->buffer->capacity;
+}
+
+// append bytes, always count the length even if the out is full
+static void __ccwriterput(ccwriter *w, const char *s, size_t n) {
+    if (__ccwritercangrow(w) && w->len + n > w->capacity) {
+        __ccwritergrow(w, n);
+    }
+    if (w->out && w->len + n <= w->capacity) {
+        memcpy(w->out + w->len, s, n);
+    } else if (w->capacity > w->len) {
+        // the out is full: stop writing, so the out holds only the whole fragments before
+        w->capacity = w->len;
+    }
+    w->len += n;
 }
 
-// helper: free the memories holded by p, but not free p self
-void ccjsonobjrelease(void *p) {
-    ccjson_obj *obj;
-    cctypemeta *meta;
+// append a char
+static void __ccwriterputc(ccwriter *w, char c) {
+    if (__ccwritercangrow(w) && w->len >= w->capacity) {
+        __ccwritergrow(w, 1);
+    }
+    if (w->out && w->len < w->capacity) {
+        w->out[w->len] = c;
+    }
+    ++w->len;
+}
 
-    cccheck(p);
-    obj = (ccjson_obj*)p;
-    meta = ccgettypemetaof(obj->__index);
-    ccobjrelease(meta, obj);
+// the bytes have been written to out, less than len if the out is full
+#define __ccwriterwritten(w) ((w)->len < (w)->capacity ? (w)->len : (w)->capacity)
+
+// append tabs
+static void __ccwritertabs(ccwriter *w, int n) {
+    while (n-- > 0) {
+        __ccwriterputc(w, '\t');
+    }
 }
 
-// helper: free the memories holded by p, and then free p self
-void ccjsonobjfree(void *p) {
-    if (__cc_hasflag(p, __CC_JSON_OBJ) ) {
-        ccjsonobjrelease(p);
-        cc_free((char*)p);
-    }else if (__cc_hasflag(p, __CC_JSON_ARRAY) ) {
-        ccarrayfree(p);
-    }else {
-        cc_free((char*)p);
+// the digits of integer, include the sign
+static size_t __ccdigits(ccint64 i) {
+    size_t n = 1;
+    ccuint64 u = (ccuint64)i;
+    if (i < 0) {
+        ++n;
+        u = 0 - u;
     }
+    while (u >= 10) {
+        u /= 10;
+        ++n;
+    }
+    return n;
 }
 
-// helper: serial from json 
-ccibool ccjsonobjparsefrom(void *p, const char* json) {
-    ccjson_obj *obj = (ccjson_obj*)p;
-    cctypemeta *meta = ccgettypemetaof(obj->__index);
-    return ccparsefrom(meta, p, json);
+// write the integer
+static void __ccwriteint(ccwriter *w, ccint64 i) {
+    char buf[24];
+    if (w->out) {
+        __ccwriterput(w, buf, (size_t)sprintf(buf, "%lld", i));
+    } else {
+        w->len += __ccdigits(i);
+    }
 }
 
-// helper: unserial to json
-char* ccjsonobjunparseto(void *p) {
-    ccjson_obj *obj = (ccjson_obj*)p;
-    cctypemeta *meta = ccgettypemetaof(obj->__index);
-    return ccunparseto(meta, p);
+// write the double, keep the same rule as print_number
+static void __ccwritenumber(ccwriter *w, double d) {
+    char buf[64];
+    int n;
+    if (d <= INT_MAX && d >= INT_MIN && fabs(((double)(int)d)-d)<=DBL_EPSILON) {
+        __ccwriteint(w, (int)d);
+        return;
+    }
+    if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60) n = snprintf(buf, sizeof(buf), "%.0f", d);
+    else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9) n = snprintf(buf, sizeof(buf), "%e", d);
+    else n = snprintf(buf, sizeof(buf), "%f", d);
+    __ccwriterput(w, buf, (size_t)n);
+}
+
+// write the escaped bytes of string (without quotes)
+static void __ccwritestringspan(ccwriter *w, const char *str, size_t len) {
+    const char *ptr = str;
+    const char *end = str + len;
+    const char *run = str;
+    unsigned char token;
+    char buf[8];
+
+    while (ptr < end) {
+        token = (unsigned char)*ptr;
+        if (token > 31 && token != '\"' && token != '\\') {
+            ++ptr;
+            continue;
+        }
+        __ccwriterput(w, run, ptr - run);
+        switch (token) {
+            case '\\': __ccwriterput(w, "\\\\", 2); break;
+            case '\"': __ccwriterput(w, "\\\"", 2); break;
+            case '\b': __ccwriterput(w, "\\b", 2); break;
+            case '\f': __ccwriterput(w, "\\f", 2); break;
+            case '\n': __ccwriterput(w, "\\n", 2); break;
+            case '\r': __ccwriterput(w, "\\r", 2); break;
+            case '\t': __ccwriterput(w, "\\t", 2); break;
+            default: __ccwriterput(w, buf, (size_t)sprintf(buf, "\\u%04x", token)); break;
+        }
+        run = ++ptr;
+    }
+    __ccwriterput(w, run, ptr - run);
 }
 
-// implement the basic json type
-// ******************************************************************************
+// write the string with escape, keep the same rule as print_string_ptr
+static void __ccwritestring(ccwriter *w, const char *str) {
+    __ccwriterputc(w, '\"');
+    __ccwritestringspan(w, str, str ? strlen(str) : 0);
+    __ccwriterputc(w, '\"');
+}
 
-// basci types
-__ccimplementtype(ccint)
-__ccimplementtype(ccint64)
-__ccimplementtype(ccnumber)
-__ccimplementtype(ccstring)
-__ccimplementtype(ccbool)
+// the projection member mask of type, NULL means all members
+static const ccuint64 *__ccwritermask(ccwriter *w, cctypemeta *meta) {
+    cccheckret(w->opts && w->opts->masks, NULL);
+    cccheckret(meta->index >= 0 && meta->index < w->opts->maskcount, NULL);
+    return w->opts->masks[meta->index];
+}
 
+// if the value will output something, the same rule as ccunparse returns not NULL
+static ccibool __ccwritable(cctypemeta *meta, void *value) {
+    cccheckret(value, ccino);
+    return meta->members != NULL
+        || meta->type == cctypeofname(ccbool)
+        || meta->type == cctypeofname(ccint)
+        || meta->type == cctypeofname(ccint64)
+        || meta->type == cctypeofname(ccnumber)
+        || meta->type == cctypeofname(ccstring);
+}
 
-// implement the example the complex type
-__ccimplementtypebegin(ccconfig)
-__ccimplementmember(ccconfig, ccint, ver)
-__ccimplementmember(ccconfig, ccint64, ver64)
-__ccimplementmember(ccconfig, ccbool, has)
-__ccimplementmember(ccconfig, ccstring, detail)
-__ccimplementmember_array(ccconfig, ccint, skips)
-__ccimplementtypeend(ccconfig)
+// if the member value equals to the default: 0, false, NULL string, empty array or the declared default
+static ccibool __ccmemberisdefault(ccmembermeta *mmeta, void *value) {
+    cctypemeta *meta = mmeta->type;
+    const void *def = mmeta->defaultvalue;
+
+    if (mmeta->compose == enumflagcompose_array) {
+        return ccarraylen(*(void**)value) == 0;
+    }
+    // if compose point need deref
+    if (mmeta->compose == enumflagcompose_point) {
+        value = *(void**)value;
+        cccheckret(value, cciyes);
+    }
+    if (meta->type == cctypeofname(ccbool)) {
+        return !*(ccbool*)value == !(def ? *(const ccbool*)def : 0);
+    } else if (meta->type == cctypeofname(ccint)) {
+        return *(ccint*)value == (def ? *(const ccint*)def : 0);
+    } else if (meta->type == cctypeofname(ccint64)) {
+        return *(ccint64*)value == (def ? *(const ccint64*)def : 0);
+    } else if (meta->type == cctypeofname(ccnumber)) {
+        return *(ccnumber*)value == (def ? *(const ccnumber*)def : 0);
+    } else if (meta->type == cctypeofname(ccstring)) {
+        if (*(ccstring*)value == NULL) {
+            return cciyes;
+        }
+        return def && *(const ccstring*)def && strcmp(*(ccstring*)value, *(const ccstring*)def) == 0;
+    }
+    return ccino;
+}
+
+// precompute the key literal of member: "name":
+static void __ccmakekey(ccmembermeta *member) {
+    ccwriter w;
+    __ccwriterinit(&w, NULL, 0, NULL);
+    __ccwritestring(&w, member->name);
+    member->keylen = w.len + 1;
+    member->key = cc_alloc_uninit(member->keylen);
+    __ccwriterinit(&w, member->key, member->keylen, NULL);
+    __ccwritestring(&w, member->name);
+    __ccwriterputc(&w, ':');
+}
+
+// write the key of member: "name": or "index": with indexkey flag
+static void __ccwritekey(ccwriter *w, ccmembermeta *mmeta, int depth, int count) {
+    if (count) {
+        __ccwriterputc(w, ',');
+    }
+    if (w->fmt) {
+        __ccwriterputc(w, '\n');
+        __ccwritertabs(w, depth);
+    }
+    if (w->opts && (w->opts->flag & enumflagccunparse_indexkey)) {
+        __ccwriterputc(w, '\"');
+        __ccwriteint(w, mmeta->idx);
+        __ccwriterput(w, "\":", 2);
+    } else {
+        __ccwriterput(w, mmeta->key, mmeta->keylen);
+    }
+    if (w->fmt) {
+        __ccwriterputc(w, '\t');
+    }
+}
+
+// forward declare
+static ccibool __ccwritemember(ccwriter *w, ccmembermeta *mmeta, void *value, int depth, int count);
+
+// write the value with type meta
+static void __ccwritevalue(ccwriter *w, cctypemeta *meta, void *value, int depth) {
+    ccmemberiterator ite;
+    ccmembermeta *member;
+    int count = 0;
+
+    // be sure all the meta will be init before use
+    ccinittypemeta(meta);
+    if (meta->members) {
+        if (ccobjnullis(value)) {
+            __ccwriterput(w, "null", 4);
+            return;
+        }
+        __ccwriterputc(w, '{');
+        __ccmemberiteratorinit(&ite, meta, value, __ccwritermask(w, meta), ccino);
+        while ((member = __ccmemberiteratornext(&ite))) {
+            if (__ccwritemember(w, member, (char*)value + member->offset, depth+1, count)) {
+                ++count;
+            }
+        }
+        if (w->fmt) {
+            __ccwriterputc(w, '\n');
+            __ccwritertabs(w, count ? depth : depth-1);
+        }
+        __ccwriterputc(w, '}');
+    } else if (meta->type == cctypeofname(ccbool)) {
+        if (*(ccbool*)value) {
+            __ccwriterput(w, "true", 4);
+        } else {
+            __ccwriterput(w, "false", 5);
+        }
+    } else if (meta->type == cctypeofname(ccint)) {
+        __ccwriteint(w, *(ccint*)value);
+    } else if (meta->type == cctypeofname(ccint64)) {
+        __ccwriteint(w, *(ccint64*)value);
+    } else if (meta->type == cctypeofname(ccnumber)) {
+        __ccwritenumber(w, *(ccnumber*)value);
+    } else if (meta->type == cctypeofname(ccstring)) {
+        if (*(ccstring*)value) {
+            __ccwritestring(w, *(ccstring*)value);
+        } else {
+            __ccwriterput(w, "null", 4);
+        }
+    }
+}
+
+// write the elements [from, to) of array, return the count of elements written
+static int __ccwritearrayrange(ccwriter *w, cctypemeta *meta, void *varray, int from, int to, int depth) {
+    char *v = (char*)varray;
+    int i, n;
+    for (i=from, n=0; i<to; ++i) {
+        if (ccarrayisnull(varray, i)) {
+            if (n++) {
+                __ccwriterput(w, ", ", w->fmt ? 2 : 1);
+            }
+            __ccwriterput(w, "null", 4);
+        } else if (ccarrayhas(varray, i) && __ccwritable(meta, v + i * meta->size)) {
+            if (n++) {
+                __ccwriterput(w, ", ", w->fmt ? 2 : 1);
+            }
+            __ccwritevalue(w, meta, v + i * meta->size, depth);
+        }
+    }
+    return n;
+}
+
+// parallel: the default elements count of chunk
+#define __ccwritechunksize 4096
+
+// parallel: the chunk of array written by worker
+typedef struct __ccwritechunk {
+    ccbuffer buffer;
+    int n;
+}__ccwritechunk;
+
+// parallel: the array task shared by all workers
+typedef struct __ccwritetask {
+    ccunparseopts opts;     // copy of opts without threads, no nested parallel
+    cctypemeta *meta;
+    void *varray;
+    int len;
+    int depth;
+    int chunksize;
+    int chunkcount;
+    __ccwritechunk *chunks;
+    int workers;
+}__ccwritetask;
+
+// parallel: the worker context
+typedef struct __ccwriteworker {
+    __ccwritetask *task;
+    int worker;
+}__ccwriteworker;
+
+// parallel: worker write the chunks: worker, worker + workers, ...
+static void __ccwriteworkerrun(__ccwriteworker *worker) {
+    __ccwritetask *task = worker->task;
+    __ccwritechunk *chunk;
+    ccwriter w;
+    int c, from, to;
+    for (c=worker->worker; c<task->chunkcount; c+=task->workers) {
+        chunk = task->chunks + c;
+        from = c * task->chunksize;
+        to = from + task->chunksize > task->len ? task->len : from + task->chunksize;
+        __ccwriterinitbuffer(&w, &chunk->buffer, &task->opts);
+        chunk->n = __ccwritearrayrange(&w, task->meta, task->varray, from, to, task->depth);
+        chunk->buffer.len = w.len;
+    }
+}
+
+#ifdef WIN32
+typedef HANDLE __ccthread;
+static DWORD WINAPI __ccwriteworkerthread(LPVOID p) {
+    __ccwriteworkerrun((__ccwriteworker*)p);
+    return 0;
+}
+#define __ccthreadcreate(t, f, arg) ((*(t) = CreateThread(NULL, 0, f, arg, 0, NULL)) != NULL)
+#define __ccthreadjoin(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#else
+typedef pthread_t __ccthread;
+static void *__ccwriteworkerthread(void *p) {
+    __ccwriteworkerrun((__ccwriteworker*)p);
+    return NULL;
+}
+#define __ccthreadcreate(t, f, arg) (pthread_create(t, NULL, f, arg) == 0)
+#define __ccthreadjoin(t) pthread_join(t, NULL)
+#endif
+
+// write the array elements by chunks on worker threads, then splice the chunks in order,
+// return ccino if the array is not large enough or parallel is not enabled
+static ccibool __ccwritearrayparallel(ccwriter *w, cctypemeta *meta, void *varray, int len, int depth) {
+    __ccwritetask task;
+    __ccwriteworker *workers;
+    __ccthread *threads;
+    ccibool *started;
+    int i, n;
+
+    // only when writing, the size caculating just goes on
+    cccheckret(w->out && w->opts && w->opts->threads > 1, ccino);
+    task.chunksize = w->opts->chunksize > 0 ? w->opts->chunksize : __ccwritechunksize;
+    cccheckret(len > task.chunksize, ccino);
+
+    task.opts = *w->opts;
+    task.opts.threads = 0;
+    task.meta = meta;
+    task.varray = varray;
+    task.len = len;
+    task.depth = depth;
+    task.chunkcount = (len + task.chunksize - 1) / task.chunksize;
+    task.workers = w->opts->threads < task.chunkcount ? w->opts->threads : task.chunkcount;
+    task.chunks = (__ccwritechunk*)cc_alloc(sizeof(__ccwritechunk) * task.chunkcount);
+    memset(task.chunks, 0, sizeof(__ccwritechunk) * task.chunkcount);
+    workers = (__ccwriteworker*)cc_alloc(sizeof(__ccwriteworker) * task.workers);
+    threads = (__ccthread*)cc_alloc(sizeof(__ccthread) * task.workers);
+    started = (ccibool*)cc_alloc(sizeof(ccibool) * task.workers);
+
+    // the current thread is the worker 0
+    for (i=0; i<task.workers; ++i) {
+        workers[i].task = &task;
+        workers[i].worker = i;
+        started[i] = i && __ccthreadcreate(&threads[i], __ccwriteworkerthread, &workers[i]);
+    }
+    __ccwriteworkerrun(&workers[0]);
+    for (i=1; i<task.workers; ++i) {
+        if (started[i]) {
+            __ccthreadjoin(threads[i]);
+        } else {
+            // fail to create thread, just do it here
+            __ccwriteworkerrun(&workers[i]);
+        }
+    }
+
+    // splice in order
+    for (i=0, n=0; i<task.chunkcount; ++i) {
+        if (task.chunks[i].n) {
+            if (n++) {
+                __ccwriterput(w, ", ", w->fmt ? 2 : 1);
+            }
+            __ccwriterput(w, task.chunks[i].buffer.data, task.chunks[i].buffer.len);
+        }
+        ccbufferrelease(&task.chunks[i].buffer);
+    }
+
+    cc_free((char*)started);
+    cc_free((char*)threads);
+    cc_free((char*)workers);
+    cc_free((char*)task.chunks);
+    return cciyes;
+}
+
+// write the streaming member chunk by chunk from the producer
+static void __ccwritestream(ccwriter *w, const ccstringstream *stream, void *obj) {
+    char buf[4096];
+    size_t offset = 0, n;
+    __ccwriterputc(w, '\"');
+    while ((n = stream->produce(stream->ud, obj, offset, buf, sizeof(buf))) > 0) {
+        __ccwritestringspan(w, buf, n);
+        offset += n;
+    }
+    __ccwriterputc(w, '\"');
+}
+
+// write the member as "name": value, return ccino if nothing written
+static ccibool __ccwritemember(ccwriter *w, ccmembermeta *mmeta, void *value, int depth, int count) {
+    cctypemeta *meta;
+    const ccstringstream *stream;
+    void *varray = NULL;
+    int len;
+
+    meta = mmeta->type;
+    cccheckret(meta, ccino);
+    stream = w->opts && w->opts->streamcount ?
+        __ccstreamof(w->opts->streams, w->opts->streamcount, mmeta) : NULL;
+    if (stream && stream->produce) {
+        __ccwritekey(w, mmeta, depth, count);
+        __ccwritestream(w, stream, (char*)value - mmeta->offset);
+        return cciyes;
+    }
+    if (w->opts && (w->opts->flag & enumflagccunparse_omitdefault)) {
+        cccheckret(!__ccmemberisdefault(mmeta, value), ccino);
+    }
+    if (mmeta->compose == enumflagcompose_array) {
+        varray = *(void**)value;
+    } else {
+        // if compose point need deref
+        if (mmeta->compose == enumflagcompose_point) {
+            value = *(void**)value;
+        }
+        cccheckret(__ccwritable(meta, value), ccino);
+    }
+
+    __ccwritekey(w, mmeta, depth, count);
+
+    // value
+    if (mmeta->compose == enumflagcompose_array) {
+        __ccwriterputc(w, '[');
+        len = (int)ccarraylen(varray);
+        if (!__ccwritearrayparallel(w, meta, varray, len, depth+1)) {
+            __ccwritearrayrange(w, meta, varray, 0, len, depth+1);
+        }
+        __ccwriterputc(w, ']');
+    } else {
+        __ccwritevalue(w, meta, value, depth);
+    }
+    return cciyes;
+}
+
+#if CCDirtyMembers
+// forward declare
+static ccibool __ccmemberhasdirty(ccmembermeta *mmeta, void *value);
+
+// if the object or any sub objects have changes since last checkpoint
+static ccibool __ccobjhasdirty(cctypemeta *meta, void *value) {
+    ccmemberiterator ite;
+    ccmembermeta *member;
+    ccjson_obj *obj;
+    int i;
+
+    cccheckret(value && meta->members, ccino);
+    obj = __ccobj(value);
+    for (i=0; i<meta->membercount; i+=64) {
+        if (__ccdirtyword(obj, i)) {
+            return cciyes;
+        }
+    }
+    __ccmemberiteratorinit(&ite, meta, value, NULL, ccino);
+    while ((member = __ccmemberiteratornext(&ite))) {
+        if (__ccmemberhasdirty(member, (char*)value + member->offset)) {
+            return cciyes;
+        }
+    }
+    return ccino;
+}
+
+// if the sub objects of member have changes since last checkpoint
+static ccibool __ccmemberhasdirty(ccmembermeta *mmeta, void *value) {
+    cctypemeta *meta = mmeta->type;
+    char *v;
+    int i, len;
+
+    cccheckret(meta, ccino);
+    ccinittypemeta(meta);
+    cccheckret(meta->members, ccino);
+    if (mmeta->compose == enumflagcompose_array) {
+        v = (char*)(*(void**)value);
+        len = (int)ccarraylen(v);
+        for (i=0; i<len; ++i) {
+            if (__ccobjhasdirty(meta, v + i * meta->size)) {
+                return cciyes;
+            }
+        }
+        return ccino;
+    }
+    // if compose point need deref
+    if (mmeta->compose == enumflagcompose_point) {
+        value = *(void**)value;
+    }
+    return __ccobjhasdirty(meta, value);
+}
+
+// write the changes of object since last checkpoint
+static void __ccwritedirty(ccwriter *w, cctypemeta *meta, void *value, int depth) {
+    ccmemberiterator ite;
+    ccmembermeta *member;
+    void *mvalue;
+    ccibool written;
+    int count = 0;
+
+    if (ccobjnullis(value)) {
+        __ccwriterput(w, "null", 4);
+        return;
+    }
+    __ccwriterputc(w, '{');
+    __ccmemberiteratorinit(&ite, meta, value, __ccwritermask(w, meta), cciyes);
+    while ((member = __ccmemberiteratornext(&ite))) {
+        mvalue = (char*)value + member->offset;
+        written = ccino;
+        if (ccobjisdirty(value, member->idx)) {
+            if (ccobjhas(value, member->idx)) {
+                written = __ccwritemember(w, member, mvalue, depth+1, count);
+            }
+            if (!written) {
+                // unset, null, or nothing to write (the NULL pointer): the change is written as null
+                __ccwritekey(w, member, depth+1, count);
+                __ccwriterput(w, "null", 4);
+                written = cciyes;
+            }
+        } else if (__ccmemberhasdirty(member, mvalue)) {
+            if (member->compose == enumflagcompose_array) {
+                // the array is written as a whole
+                written = __ccwritemember(w, member, mvalue, depth+1, count);
+            } else {
+                __ccwritekey(w, member, depth+1, count);
+                if (member->compose == enumflagcompose_point) {
+                    mvalue = *(void**)mvalue;
+                }
+                __ccwritedirty(w, member->type, mvalue, depth+1);
+                written = cciyes;
+            }
+        }
+        if (written) {
+            ++count;
+        }
+    }
+    if (w->fmt) {
+        __ccwriterputc(w, '\n');
+        __ccwritertabs(w, count ? depth : depth-1);
+    }
+    __ccwriterputc(w, '}');
+}
+
+// checkpoint: clear all the dirty bits of p and sub objects
+void ccobjclean(cctypemeta *meta, void *value) {
+    ccmemberiterator ite;
+    ccmembermeta *member;
+    ccjson_obj *obj;
+    void *mvalue;
+    char *v;
+    int i, len;
+
+    cccheck(meta && value);
+    ccinittypemeta(meta);
+    cccheck(meta->members);
+    obj = __ccobj(value);
+    for (i=0; i<meta->membercount; i+=64) {
+        __ccdirtyword(obj, i) = 0;
+    }
+    __ccmemberiteratorinit(&ite, meta, value, NULL, ccino);
+    while ((member = __ccmemberiteratornext(&ite))) {
+        if (member->type == NULL) {
+            continue;
+        }
+        mvalue = (char*)value + member->offset;
+        if (member->compose == enumflagcompose_array) {
+            v = (char*)(*(void**)mvalue);
+            len = (int)ccarraylen(v);
+            for (i=0; i<len && member->type->members; ++i) {
+                ccobjclean(member->type, v + i * member->type->size);
+            }
+        } else {
+            if (member->compose == enumflagcompose_point) {
+                mvalue = *(void**)mvalue;
+            }
+            ccobjclean(member->type, mvalue);
+        }
+    }
+}
+#else
+// no dirty bits: nothing to clean
+void ccobjclean(cctypemeta *meta, void *value) {
+    cc_unused(meta);
+    cc_unused(value);
+}
+#endif
+
+// caculate the exact length of the json string of value (without the end 0)
+size_t ccunparse_size(cctypemeta *meta, void *value, const ccunparseopts *opts) {
+    ccwriter w;
+    cccheckret(meta, 0);
+    ccinittypemeta(meta);
+    cccheckret(__ccwritable(meta, value), 0);
+
+    __ccwriterinit(&w, NULL, 0, opts);
+    __ccwritevalue(&w, meta, value, 0);
+    return w.len;
+}
+
+// unserial the json object and append to buffer, return the bytes appended
+size_t ccunparse_tobuffer(cctypemeta *meta, void *value, ccbuffer *buffer, const ccunparseopts *opts) {
+    ccwriter w;
+    size_t len;
+    cccheckret(meta && buffer, 0);
+    ccinittypemeta(meta);
+    cccheckret(__ccwritable(meta, value), 0);
+
+    len = buffer->len;
+    __ccwriterinitbuffer(&w, buffer, opts);
+    __ccwritevalue(&w, meta, value, 0);
+    buffer->len = w.len;
+    buffer->data[buffer->len] = 0;
+    return buffer->len - len;
+}
+
+// unserial the members changed since last checkpoint and append to buffer, then clear the dirty bits
+size_t ccunparse_dirty(cctypemeta *meta, void *value, ccbuffer *buffer, const ccunparseopts *opts) {
+#if CCDirtyMembers
+    ccwriter w;
+    ccunparseopts dirtyopts = {0, NULL, 0, 0, 0, NULL, 0};
+    size_t len;
+    cccheckret(meta && buffer, 0);
+    ccinittypemeta(meta);
+    cccheckret(__ccobjhasdirty(meta, value), 0);
+
+    // the changed member must be written even if it equals to default
+    if (opts) {
+        dirtyopts = *opts;
+        dirtyopts.flag &= ~enumflagccunparse_omitdefault;
+    }
+    len = buffer->len;
+    __ccwriterinitbuffer(&w, buffer, &dirtyopts);
+    __ccwritedirty(&w, meta, value, 0);
+    buffer->len = w.len;
+    buffer->data[buffer->len] = 0;
+
+    ccobjclean(meta, value);
+    return buffer->len - len;
+#else
+    // no dirty bits: nothing changed
+    cc_unused(meta);
+    cc_unused(value);
+    cc_unused(buffer);
+    cc_unused(opts);
+    return 0;
+#endif
+}
+
+// unserial the json object to out (end with 0), return the length of json string (without the end 0)
+size_t ccunparse_tofixed(cctypemeta *meta, void *value, char *out, size_t outlen, const ccunparseopts *opts) {
+    ccwriter w;
+    cccheckret(meta, 0);
+    ccinittypemeta(meta);
+    cccheckret(__ccwritable(meta, value), 0);
+
+    // keep one byte for the end 0
+    __ccwriterinit(&w, outlen ? out : NULL, outlen ? outlen-1 : 0, opts);
+    __ccwritevalue(&w, meta, value, 0);
+    if (outlen) {
+        out[__ccwriterwritten(&w)] = 0;
+    }
+    return w.len;
+}
+
+// unserial the json object to a json string, returned string neededcall cc_free to free the memory
+char *ccunparseto(cctypemeta *meta, void *value) {
+    ccwriter w;
+    char *content = NULL;
+    size_t size = ccunparse_size(meta, value, NULL);
+    cccheckret(size, NULL);
+
+    // alloc the exact size once
+    content = cc_alloc_uninit(size);
+    __ccwriterinit(&w, content, size, NULL);
+    __ccwritevalue(&w, meta, value, 0);
+    return content;
+}
+
+#ifndef WIN32
+// reserve the blocks of file for len bytes, so writing the shared mapping never hits ENOSPC (SIGBUS)
+static ccibool __ccfilereserve(int fd, size_t len) {
+#if defined(__APPLE__)
+    fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)len, 0};
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+        return ccino;
+    }
+    return ftruncate(fd, (off_t)len) == 0;
+#else
+    return posix_fallocate(fd, 0, (off_t)len) == 0;
+#endif
+}
+#endif
+
+// unserial the json object to file directly, return the length of file, 0 means failed
+size_t ccunparse_tofile(cctypemeta *meta, void *value, const char *fn, const ccunparseopts *opts, ccibool sync) {
+#ifdef WIN32
+    // no mmap: write through the buffer, sync flushs the crt buffer and commits the os cache to disk
+    ccbuffer buffer;
+    size_t len = 0;
+    FILE *file;
+    cccheckret(meta && fn, 0);
+    ccbufferinit(&buffer, 0);
+    if (ccunparse_tobuffer(meta, value, &buffer, opts)) {
+        file = fopen(fn, "wb");
+        if (file) {
+            len = fwrite(buffer.data, 1, buffer.len, file);
+            if (len != buffer.len) {
+                len = 0;
+            }
+            if (sync && len && (fflush(file) != 0 || _commit(_fileno(file)) != 0)) {
+                len = 0;
+            }
+            if (fclose(file) != 0) {
+                len = 0;
+            }
+        }
+    }
+    ccbufferrelease(&buffer);
+    return len;
+#else
+    ccwriter w;
+    int fd;
+    void *out;
+    size_t size, len = 0;
+    cccheckret(meta && fn, 0);
+    ccinittypemeta(meta);
+    cccheckret(__ccwritable(meta, value), 0);
+
+    // size once, then reserve and map the file only once
+    size = ccunparse_size(meta, value, opts);
+    cccheckret(size, 0);
+
+    fd = open(fn, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    cccheckret(fd >= 0, 0);
+
+    if (__ccfilereserve(fd, size)) {
+        out = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (out != MAP_FAILED) {
+            __ccwriterinit(&w, (char*)out, size, opts);
+            __ccwritevalue(&w, meta, value, 0);
+            // the stream producer gives the different length, the file is not complete
+            if (w.len == size) {
+                len = size;
+            }
+            if (sync && len && msync(out, size, MS_SYNC) != 0) {
+                len = 0;
+            }
+            munmap(out, size);
+        }
+    }
+    if (sync && len && fsync(fd) != 0) {
+        len = 0;
+    }
+    if (!len && ftruncate(fd, 0) != 0) {
+        len = 0;
+    }
+    close(fd);
+    return len;
+#endif
+}
+
+// ******************************************************************************
+// text to text transcoder: minify and prettify without the DOM
+
+// the container stack of transcoder, deeper levels are treated as array (written inline)
+#define __cctranscodemaxdepth 1024
+
+// the chars end a literal (number, true, false, null)
+static ccibool __cctranscodedelim(char c) {
+    switch (c) {
+        case ' ': case '\t': case '\r': case '\n':
+        case ',': case ':': case '[': case ']': case '{': case '}':
+        case '"': case '/': case 0:
+            return cciyes;
+    }
+    return ccino;
+}
+
+// new line and indent: tab if indent is 0, else spaces
+static void __cctranscodeindent(ccwriter *w, int depth, int indent) {
+    int i;
+    __ccwriterputc(w, '\n');
+    if (indent <= 0) {
+        __ccwritertabs(w, depth);
+        return;
+    }
+    for (i=0; i<depth*indent; ++i) {
+        __ccwriterputc(w, ' ');
+    }
+}
+
+// copy the run of json: ccminify can be in place, so the out may overlap the json
+static void __cctranscodeput(ccwriter *w, const char *run, size_t n) {
+    if (!__ccwritercangrow(w) && w->out && w->len + n <= w->capacity) {
+        memmove(w->out + w->len, run, n);
+        w->len += n;
+        return;
+    }
+    __ccwriterput(w, run, n);
+}
+
+// the bytes of word x equal to c get 0x80, exact for every byte (no borrow between bytes)
+#define __ccbytes(c) ((ccuint64)0x0101010101010101ULL * (unsigned char)(c))
+#define __ccbyteslow7 ((ccuint64)0x7f7f7f7f7f7f7f7fULL)
+#define __ccbyteseq(x, c) (~(((((x) ^ __ccbytes(c)) & __ccbyteslow7) + __ccbyteslow7) | ((x) ^ __ccbytes(c)) | __ccbyteslow7))
+
+// the white space of json
+#define __cctranscodespace(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+// skip the white spaces, 8 bytes once while all of them are white spaces (the indents)
+static const char *__cctranscodespaces(const char *c, const char *end) {
+    ccuint64 x;
+    while (end - c >= 8) {
+        memcpy(&x, c, 8);
+        if ((__ccbyteseq(x, ' ') | __ccbyteseq(x, '\t') | __ccbyteseq(x, '\r') | __ccbyteseq(x, '\n'))
+            != __ccbytes(0x80)) {
+            break;
+        }
+        c += 8;
+    }
+    while (c < end && __cctranscodespace(*c)) ++c;
+    return c;
+}
+
+// the end of string literal from the open quote: memchr the quotes, the one after odd backslashes is escaped
+static const char *__cctranscodestring(const char *c, const char *end) {
+    const char *q, *b;
+    for (++c; c < end && (q = (const char*)memchr(c, '"', end - c)); c = q + 1) {
+        for (b=q; b > c && b[-1] == '\\'; --b);
+        if ((q - b) % 2 == 0) {
+            return q + 1;
+        }
+    }
+    return end;
+}
+
+// the end of /* comment, or the end of json if not closed
+static const char *__cctranscodecomment(const char *c, const char *end) {
+    const char *star;
+    for (c+=2; c < end && (star = (const char*)memchr(c, '*', end - c)); c = star + 1) {
+        if (star+1 < end && star[1] == '/') {
+            return star + 2;
+        }
+    }
+    return end;
+}
+
+// single pass: skip white spaces and comments (the same as cJSON_Minify), copy the strings and literals as runs,
+// re-indent the structure if w->fmt; the json ends at the first 0 in len
+static void __cctranscode(ccwriter *w, const char *json, size_t len, int indent) {
+    const char *c = json, *end = json + len, *run;
+    ccuint64 objects[__cctranscodemaxdepth/64] = {0};
+    int depth = 0;
+    ccibool open = ccino;   // just after '{', need new line before the first member
+    ccibool empty = ccino;  // the object closing is empty: {}
+
+    if ((run = (const char*)memchr(json, 0, len))) {
+        end = run;
+    }
+    while (c < end) {
+        // skip white spaces
+        if (__cctranscodespace(*c)) {
+            c = __cctranscodespaces(c, end);
+            continue;
+        }
+        // skip comments
+        if (*c == '/' && c+1 < end && c[1] == '/') {
+            run = (const char*)memchr(c, '\n', end - c);
+            c = run ? run : end;
+            continue;
+        }
+        if (*c == '/' && c+1 < end && c[1] == '*') {
+            c = __cctranscodecomment(c, end);
+            continue;
+        }
+        // the first token in object
+        if (open) {
+            open = ccino;
+            empty = *c == '}';
+            if (!empty) {
+                __cctranscodeindent(w, depth, indent);
+            }
+        }
+        switch (*c) {
+            case '"': {
+                // string literals, which are \" sensitive
+                run = c;
+                c = __cctranscodestring(c, end);
+                __cctranscodeput(w, run, c - run);
+                break; }
+            case '{':
+            case '[': {
+                __ccwriterputc(w, *c);
+                if (depth < __cctranscodemaxdepth) {
+                    if (*c == '{') {
+                        objects[depth/64] |= __ccbit(depth);
+                    } else {
+                        objects[depth/64] &= ~__ccbit(depth);
+                    }
+                }
+                open = w->fmt && *c == '{';
+                ++depth;
+                ++c;
+                break; }
+            case '}':
+            case ']': {
+                // the stray closing of malformed text is copied as is, never below the top level
+                if (depth == 0) {
+                    __ccwriterputc(w, *c++);
+                    break;
+                }
+                --depth;
+                if (w->fmt && *c == '}') {
+                    // the empty object is the same as cJSON_Print: {\n}
+                    __cctranscodeindent(w, empty ? depth-1 : depth, indent);
+                }
+                empty = ccino;
+                __ccwriterputc(w, *c++);
+                break; }
+            case ',': {
+                __ccwriterputc(w, *c++);
+                if (w->fmt) {
+                    if (depth > 0 && depth <= __cctranscodemaxdepth && (objects[(depth-1)/64] & __ccbit(depth-1))) {
+                        __cctranscodeindent(w, depth, indent);
+                    } else {
+                        __ccwriterputc(w, ' ');
+                    }
+                }
+                break; }
+            case ':': {
+                __ccwriterputc(w, *c++);
+                if (w->fmt) {
+                    __ccwriterputc(w, indent > 0 ? ' ' : '\t');
+                }
+                break; }
+            default: {
+                // number, true, false, null, or anything else: copy as run
+                for (run=c++; c < end && !__cctranscodedelim(*c); ++c);
+                __cctranscodeput(w, run, c - run);
+                break; }
+        }
+    }
+}
+
+// strip white spaces and comments, out need len+1 bytes and can be json (in place), return the length of out
+size_t ccminify(const char *json, size_t len, char *out) {
+    ccwriter w;
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0, NULL, 0};
+    cccheckret(json && out, 0);
+    __ccwriterinit(&w, out, len, &opts);
+    __cctranscode(&w, json, len, 0);
+    out[w.len] = 0;
+    return w.len;
+}
+
+// minify and append to buffer, return the bytes appended
+size_t ccminify_tobuffer(const char *json, size_t len, ccbuffer *buffer) {
+    ccwriter w;
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0, NULL, 0};
+    size_t old;
+    cccheckret(json && buffer, 0);
+    // the minified is never longer than json
+    ccbufferreserve(buffer, buffer->len + len);
+    old = buffer->len;
+    __ccwriterinitbuffer(&w, buffer, &opts);
+    __cctranscode(&w, json, len, 0);
+    buffer->len = w.len;
+    buffer->data[buffer->len] = 0;
+    return buffer->len - old;
+}
+
+// re-indent json text to out (end with 0), return the length (see ccunparse_tofixed)
+size_t ccprettify(const char *json, size_t len, char *out, size_t outlen, int indent) {
+    ccwriter w;
+    cccheckret(json, 0);
+    // keep one byte for the end 0
+    __ccwriterinit(&w, outlen ? out : NULL, outlen ? outlen-1 : 0, NULL);
+    __cctranscode(&w, json, len, indent);
+    if (outlen) {
+        out[__ccwriterwritten(&w)] = 0;
+    }
+    return w.len;
+}
+
+// prettify and append to buffer, return the bytes appended
+size_t ccprettify_tobuffer(const char *json, size_t len, ccbuffer *buffer, int indent) {
+    ccwriter w;
+    size_t old;
+    cccheckret(json && buffer, 0);
+    old = buffer->len;
+    __ccwriterinitbuffer(&w, buffer, NULL);
+    __cctranscode(&w, json, len, indent);
+    buffer->len = w.len;
+    if (buffer->data) {
+        buffer->data[buffer->len] = 0;
+    }
+    return buffer->len - old;
+}
+
+// ******************************************************************************
+// ndjson writer
+#ifdef WIN32
+#define __ccfdwrite(fd, data, len) _write(fd, data, (unsigned int)(len))
+#else
+#define __ccfdwrite(fd, data, len) write(fd, data, len)
+#endif
+
+// the default flush threshold of ndjson writer
+#define __ccndjsonthreshold (64*1024)
+
+// init the writer, write to file if file is not NULL else to fd
+void ccndjson_writerinit(ccndjson_writer *w, FILE *file, int fd, size_t threshold, const ccunparseopts *opts) {
+    cccheck(w);
+    w->file = file;
+    w->fd = fd;
+    w->threshold = threshold ? threshold : __ccndjsonthreshold;
+    w->flushed = 0;
+    w->error = ccino;
+    if (opts) {
+        w->opts = *opts;
+    } else {
+        memset(&w->opts, 0, sizeof(w->opts));
+    }
+    // one object one line
+    w->opts.flag |= enumflagccunparse_compact;
+    ccbufferinit(&w->buffer, w->threshold);
+}
+
+// write the buffered lines to file or fd
+ccibool ccndjson_flush(ccndjson_writer *w) {
+    size_t done = 0;
+    long n;
+
+    cccheckret(w && !w->error, ccino);
+    while (done < w->buffer.len) {
+        if (w->file) {
+            n = (long)fwrite(w->buffer.data + done, 1, w->buffer.len - done, w->file);
+        } else {
+            n = (long)__ccfdwrite(w->fd, w->buffer.data + done, w->buffer.len - done);
+        }
+        if (n <= 0) {
+            w->error = cciyes;
+            break;
+        }
+        done += (size_t)n;
+    }
+    w->flushed += done;
+    // keep the lines not written
+    if (done) {
+        memmove(w->buffer.data, w->buffer.data + done, w->buffer.len - done);
+        w->buffer.len -= done;
+    }
+    if (!w->error && w->file) {
+        w->error = fflush(w->file) != 0;
+    }
+    return !w->error;
+}
+
+// append one line to buffer
+static void __ccndjson_writeline(ccndjson_writer *w, cctypemeta *meta, void *value) {
+    ccwriter writer;
+    __ccwriterinitbuffer(&writer, &w->buffer, &w->opts);
+    if (__ccwritable(meta, value)) {
+        __ccwritevalue(&writer, meta, value, 0);
+    } else {
+        __ccwriterput(&writer, "null", 4);
+    }
+    __ccwriterputc(&writer, '\n');
+    w->buffer.len = writer.len;
+}
+
+// write the object as one line, flush if the buffered bytes reach the threshold
+ccibool ccndjson_write(ccndjson_writer *w, cctypemeta *meta, void *value) {
+    cccheckret(w && meta && !w->error, ccino);
+    ccinittypemeta(meta);
+
+    __ccndjson_writeline(w, meta, value);
+    if (w->buffer.len >= w->threshold) {
+        return ccndjson_flush(w);
+    }
+    return cciyes;
+}
+
+// write every element of array as one line, return the lines written
+int ccndjson_writearray(ccndjson_writer *w, cctypemeta *meta, void *array) {
+    char *v = (char*)array;
+    int i, len, n = 0;
+    cccheckret(w && meta && !w->error, 0);
+    ccinittypemeta(meta);
+
+    len = (int)ccarraylen(array);
+    for (i=0; i<len && !w->error; ++i) {
+        if (ccarrayisnull(array, i)) {
+            __ccndjson_writeline(w, meta, NULL);
+        } else if (ccarrayhas(array, i)) {
+            __ccndjson_writeline(w, meta, v + i * meta->size);
+        } else {
+            continue;
+        }
+        ++n;
+        if (w->buffer.len >= w->threshold) {
+            ccndjson_flush(w);
+        }
+    }
+    return n;
+}
+
+// flush and free the buffer, the file or fd will not be closed
+ccibool ccndjson_writerrelease(ccndjson_writer *w) {
+    ccibool ok;
+    cccheckret(w, ccino);
+    ok = ccndjson_flush(w);
+    ccbufferrelease(&w->buffer);
+    return ok;
+}
+
+// ******************************************************************************
+// structured log: every thread writes lines into its own buffer without lock, the full buffers are queued,
+// the background thread writes the queue to file and takes the lines left in buffers every interval
+
+// the line buffer of thread
+typedef struct __cclogbuffer {
+    ccbuffer buffer;
+    struct __cclogbuffer *next;     // in the queue or free list, or the next owned buffer
+    struct __cclogbuffer *prev;     // the prev owned buffer
+    ccibool busy;                   // atomic: __cclogidle, __cclogwriting or __cclogtaken
+}__cclogbuffer;
+
+// the states of thread buffer: the owner thread is writing a line, or the log is taking the lines
+#define __cclogidle 0
+#define __cclogwriting 1
+#define __cclogtaken 2
+
+// the log system
+static struct {
+    FILE *file;
+    ccibool running;        // atomic, read by writers without lock
+    size_t threshold;       // queue the thread buffer when reach the threshold
+    int interval;           // the background thread flush interval in ms
+    __cclogbuffer *queue;   // the full buffers wait to be written, in order
+    __cclogbuffer *tail;
+    __cclogbuffer *free;    // the written buffers to reuse
+    __cclogbuffer *owned;   // the buffers owned by threads
+}glog;
+
+// the default threshold and flush interval of log
+#define __cclogthreshold (64*1024)
+#define __ccloginterval 10
+
+// the flags shared by writers and the log: sequential consistent, set the own one and then read the other
+#ifdef _MSC_VER
+#define __cclogflagget(p) InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define __cclogflagset(p, v) InterlockedExchange((volatile LONG*)(p), (LONG)(v))
+#define __cclogflagcas(p, o, n) (InterlockedCompareExchange((volatile LONG*)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#else
+#define __cclogflagget(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define __cclogflagset(p, v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+static ccibool __cclogflagcas(ccibool *p, ccibool o, ccibool n) {
+    return __atomic_compare_exchange_n(p, &o, n, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#endif
+
+// the lock of queue and owned buffers, never taken by writing a line
+__ccmutexdefine(_g_log_mutex_get)
+#define __ccloglock __ccmutexlock(_g_log_mutex_get)
+#define __cclogunlock __ccmutexunlock(_g_log_mutex_get)
+
+#ifdef WIN32
+static DWORD glogkey = TLS_OUT_OF_INDEXES;
+#define __cclogkeycreate() (glogkey == TLS_OUT_OF_INDEXES ? (glogkey = TlsAlloc()) : glogkey)
+#define __cclogkeyget() ((__cclogbuffer*)TlsGetValue(glogkey))
+#define __cclogkeyset(v) TlsSetValue(glogkey, v)
+#define __cclogsleep(ms) Sleep(ms)
+static HANDLE glogthread;
+#else
+static pthread_key_t glogkey;
+static void __cclogthreadexit(void *p);
+static void __cclogkeycreate() {
+    static int init = 0;
+    if (!init) {
+        init = pthread_key_create(&glogkey, __cclogthreadexit) == 0;
+    }
+}
+#define __cclogkeyget() ((__cclogbuffer*)pthread_getspecific(glogkey))
+#define __cclogkeyset(v) pthread_setspecific(glogkey, v)
+#define __cclogsleep(ms) usleep((ms) * 1000)
+static pthread_t glogthread;
+#endif
+
+// the thread takes the buffer, must be locked
+static void __cclogown(__cclogbuffer *log) {
+    log->prev = NULL;
+    log->next = glog.owned;
+    if (glog.owned) {
+        glog.owned->prev = log;
+    }
+    glog.owned = log;
+}
+
+// the thread gives up the buffer, must be locked
+static void __cclogdisown(__cclogbuffer *log) {
+    if (log->prev) {
+        log->prev->next = log->next;
+    } else {
+        glog.owned = log->next;
+    }
+    if (log->next) {
+        log->next->prev = log->prev;
+    }
+    log->prev = log->next = NULL;
+}
+
+// queue the buffer to be written, must be locked
+static void __cclogqueue(__cclogbuffer *log) {
+    log->next = NULL;
+    if (glog.tail) {
+        glog.tail->next = log;
+    } else {
+        glog.queue = log;
+    }
+    glog.tail = log;
+}
+
+// queue the buffer of thread, must be locked
+static void __cclogsubmit(__cclogbuffer *log) {
+    __cclogdisown(log);
+    __cclogqueue(log);
+}
+
+// a buffer not owned: reuse the written one, must be locked
+static __cclogbuffer *__cclogspare() {
+    __cclogbuffer *log = glog.free;
+    if (log) {
+        glog.free = log->next;
+    } else {
+        log = (__cclogbuffer*)cc_alloc(sizeof(__cclogbuffer));
+        ccbufferinit(&log->buffer, glog.threshold + glog.threshold/4);
+    }
+    log->busy = __cclogidle;
+    return log;
+}
+
+// free the buffer
+static void __cclogfree(__cclogbuffer *log) {
+    ccbufferrelease(&log->buffer);
+    cc_free((char*)log);
+}
+
+#ifndef WIN32
+// the thread exit: queue the lines left, or free the buffer if the log has been closed
+static void __cclogthreadexit(void *p) {
+    __cclogbuffer *log = (__cclogbuffer*)p;
+    __ccloglock;
+    if (glog.running && log->buffer.len) {
+        __cclogsubmit(log);
+        log = NULL;
+    } else {
+        __cclogdisown(log);
+    }
+    __cclogunlock;
+    if (log) {
+        __cclogfree(log);
+    }
+}
+#endif
+
+// take the lines left in the buffers of threads to the queue, the writing ones are skipped, must be locked
+static void __cclogtakeowned() {
+    __cclogbuffer *log, *spare;
+    ccbuffer buffer;
+    for (log=glog.owned; log; log=log->next) {
+        if (!__cclogflagcas(&log->busy, __cclogidle, __cclogtaken)) {
+            continue;
+        }
+        // swap the lines with a spare buffer, the thread keeps writing to the same log
+        if (log->buffer.len) {
+            spare = __cclogspare();
+            buffer = spare->buffer;
+            spare->buffer = log->buffer;
+            log->buffer = buffer;
+            __cclogqueue(spare);
+        }
+        __cclogflagset(&log->busy, __cclogidle);
+    }
+}
+
+// write all the queued buffers to file, and recycle them
+static void __cclogwritequeue() {
+    __cclogbuffer *log, *last = NULL;
+    __ccloglock;
+    log = glog.queue;
+    glog.queue = glog.tail = NULL;
+    __cclogunlock;
+    cccheck(log);
+
+    // write without lock
+    for (last=log; ; last=last->next) {
+        if (glog.file && last->buffer.len) {
+            fwrite(last->buffer.data, 1, last->buffer.len, glog.file);
+        }
+        last->buffer.len = 0;
+        if (last->next == NULL) {
+            break;
+        }
+    }
+    if (glog.file) {
+        fflush(glog.file);
+    }
+    __ccloglock;
+    last->next = glog.free;
+    glog.free = log;
+    __cclogunlock;
+}
+
+// the background flush thread: the quiet threads' lines are written in interval too
+#ifdef WIN32
+static DWORD WINAPI __cclogthread(LPVOID p) {
+#else
+static void *__cclogthread(void *p) {
+#endif
+    (void)p;
+    while (__cclogflagget(&glog.running)) {
+        __ccloglock;
+        __cclogtakeowned();
+        __cclogunlock;
+        __cclogwritequeue();
+        __cclogsleep(glog.interval);
+    }
+    return 0;
+}
+
+// start the log system, lines will be written to file
+ccibool cclogopen(FILE *file, size_t threshold, int interval) {
+    ccibool ok;
+    __ccloglock;
+    ok = file && !glog.running;
+    if (ok) {
+        __cclogkeycreate();
+        glog.file = file;
+        glog.threshold = threshold ? threshold : __cclogthreshold;
+        glog.interval = interval > 0 ? interval : __ccloginterval;
+        __cclogflagset(&glog.running, cciyes);
+    }
+    __cclogunlock;
+    cccheckret(ok, ccino);
+#ifdef WIN32
+    glogthread = CreateThread(NULL, 0, __cclogthread, NULL, 0, NULL);
+    if (glogthread == NULL) {
+#else
+    if (pthread_create(&glogthread, NULL, __cclogthread, NULL) != 0) {
+#endif
+        __ccloglock;
+        __cclogflagset(&glog.running, ccino);
+        glog.file = NULL;
+        __cclogunlock;
+        return ccino;
+    }
+    return cciyes;
+}
+
+// serial the record to the buffer of current thread as one line, the lock is only taken
+// by the first line of thread and by queueing the full buffer
+ccibool cclogwrite(cctypemeta *meta, void *value) {
+    static const ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0, NULL, 0};
+    __cclogbuffer *log;
+    ccwriter w;
+    ccibool full;
+
+    cccheckret(meta && __cclogflagget(&glog.running), ccino);
+    ccinittypemeta(meta);
+    cccheckret(__ccwritable(meta, value), ccino);
+
+    log = __cclogkeyget();
+    if (log == NULL) {
+        __ccloglock;
+        if (glog.running) {
+            log = __cclogspare();
+            __cclogown(log);
+            __cclogkeyset(log);
+        }
+        __cclogunlock;
+        cccheckret(log, ccino);
+    }
+
+    // mark writing, wait the log taking the lines; then the close will wait this line
+    while (!__cclogflagcas(&log->busy, __cclogidle, __cclogwriting)) {
+        __cclogsleep(0);
+    }
+    if (!__cclogflagget(&glog.running)) {
+        __cclogflagset(&log->busy, __cclogidle);
+        return ccino;
+    }
+    __ccwriterinitbuffer(&w, &log->buffer, &opts);
+    __ccwritevalue(&w, meta, value, 0);
+    __ccwriterputc(&w, '\n');
+    log->buffer.len = w.len;
+    full = log->buffer.len >= glog.threshold;
+    __cclogflagset(&log->busy, __cclogidle);
+
+    if (full) {
+        __ccloglock;
+        // the lines may have been taken by the log
+        if (glog.running && log->buffer.len >= glog.threshold) {
+            __cclogkeyset(NULL);
+            __cclogsubmit(log);
+        }
+        __cclogunlock;
+    }
+    return cciyes;
+}
+
+// queue the lines of current thread
+void cclogflush() {
+    __cclogbuffer *log;
+    __ccloglock;
+    log = glog.running ? __cclogkeyget() : NULL;
+    if (log && log->buffer.len) {
+        __cclogkeyset(NULL);
+        __cclogsubmit(log);
+    }
+    __cclogunlock;
+}
+
+// stop the background thread, write all the queued lines and the lines in buffers of threads,
+// the file will not be closed
+void cclogclose() {
+    __cclogbuffer *log;
+    cclogflush();
+    __ccloglock;
+    if (!glog.running) {
+        __cclogunlock;
+        return;
+    }
+    // no more lines, the lines being written go on
+    __cclogflagset(&glog.running, ccino);
+    __cclogunlock;
+#ifdef WIN32
+    WaitForSingleObject(glogthread, INFINITE);
+    CloseHandle(glogthread);
+#else
+    pthread_join(glogthread, NULL);
+#endif
+
+    __cclogwritequeue();
+
+    // then the lines left in buffers of threads, wait the lines being written
+    __ccloglock;
+    for (log=glog.owned; log; log=log->next) {
+        while (!__cclogflagcas(&log->busy, __cclogidle, __cclogtaken)) {
+            __cclogsleep(0);
+        }
+        if (log->buffer.len) {
+            fwrite(log->buffer.data, 1, log->buffer.len, glog.file);
+            log->buffer.len = 0;
+        }
+        __cclogflagset(&log->busy, __cclogidle);
+    }
+    __cclogunlock;
+    fflush(glog.file);
+    glog.file = NULL;
+
+    // free the recycled buffers, the owned ones are kept by threads
+    __ccloglock;
+    while ((log = glog.free)) {
+        glog.free = log->next;
+        __cclogfree(log);
+    }
+    __cclogunlock;
+}
+
+// set the meta index in basic json object
+#define __cc_setmetaindex(p, index) do { \
+    ccjson_obj* obj = (ccjson_obj*)p; \
+    if(obj && obj->__index == index) { \
+        obj->__index = index; \
+    }} while(0)  
+
+// ******************************************************************************
+// helper: malloc a basic json object with type meta, we can call the ccjsonobjfree to free memories
+void *ccjsonobjalloc(cctypemeta* meta) {
+    ccjson_obj *obj;
+    ccinittypemeta(meta);
+
+    obj = (ccjson_obj*)cc_alloc(meta->size);
+    obj->__index = meta->index;
+    __cc_setflag(obj, __CC_JSON_OBJ);
+    // the declared defaults, without has
+    __ccobjapplydefaults(meta, obj, ccino, cciyes);
+    return obj;
+}
+
+// helper: free the memories holded by p, but not free p self
+void ccjsonobjrelease(void *p) {
+    ccjson_obj *obj;
+    cctypemeta *meta;
+
+    cccheck(p);
+    obj = (ccjson_obj*)p;
+    meta = ccgettypemetaof(obj->__index);
+    ccobjrelease(meta, obj);
+}
+
+// helper: free the memories holded by p, and then free p self
+void ccjsonobjfree(void *p) {
+    if (__cc_hasflag(p, __CC_JSON_OBJ) ) {
+        ccjsonobjrelease(p);
+        cc_free((char*)p);
+    }else if (__cc_hasflag(p, __CC_JSON_ARRAY) ) {
+        ccarrayfree(p);
+    }else {
+        cc_free((char*)p);
+    }
+}
+
+// helper: serial from json 
+ccibool ccjsonobjparsefrom(void *p, const char* json) {
+    ccjson_obj *obj = (ccjson_obj*)p;
+    cctypemeta *meta = ccgettypemetaof(obj->__index);
+    return ccparsefrom(meta, p, json);
+}
+
+// helper: unserial to json
+char* ccjsonobjunparseto(void *p) {
+    ccjson_obj *obj = (ccjson_obj*)p;
+    cctypemeta *meta = ccgettypemetaof(obj->__index);
+    return ccunparseto(meta, p);
+}
+
+// implement the basic json type
+// ******************************************************************************
+
+// basci types
+__ccimplementtype(ccint)
+__ccimplementtype(ccint64)
+__ccimplementtype(ccnumber)
+__ccimplementtype(ccstring)
+__ccimplementtype(ccbool)
+
+
+// implement the example the complex type
+__ccimplementtypebegin(ccconfig)
+__ccimplementmember(ccconfig, ccint, ver)
+__ccimplementmember(ccconfig, ccint64, ver64)
+__ccimplementmember(ccconfig, ccbool, has)
+__ccimplementmember(ccconfig, ccstring, detail)
+__ccimplementmember_array(ccconfig, ccint, skips)
+__ccimplementtypeend(ccconfig)
+
+// implement the memory states
+__ccimplementtypebegin(ccmemclass)
+__ccimplementmember(ccmemclass, ccint, index)
+__ccimplementmember(ccmemclass, ccint64, size)
+__ccimplementmember(ccmemclass, ccint64, capacity)
+__ccimplementmember(ccmemclass, ccint64, current)
+__ccimplementmember(ccmemclass, ccint64, hits)
+__ccimplementmember(ccmemclass, ccint64, misses)
+__ccimplementmember(ccmemclass, ccint64, overflows)
+__ccimplementmember(ccmemclass, ccint64, hold)
+__ccimplementtypeend(ccmemclass)
+
+__ccimplementtypebegin(ccmemstats)
+__ccimplementmember(ccmemstats, ccint64, size)
+__ccimplementmember(ccmemstats, ccint64, peak)
+__ccimplementmember(ccmemstats, ccint64, alloccount)
+__ccimplementmember(ccmemstats, ccint64, freecount)
+__ccimplementmember(ccmemstats, ccint64, hold)
+__ccimplementmember_array(ccmemstats, ccmemclass, classes)
+__ccimplementtypeend(ccmemstats)
 
@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <time.h>
 
 /* Set up for C function definitions, even when using C++ */
@@ -41,6 +42,12 @@ typedef unsigned int ccuint32;
 // ccibool
 typedef int ccibool;
 
+// basic json types
+typedef char* ccstring;
+typedef int ccbool;
+typedef double ccnumber;
+typedef int ccint;
+
 #define ccitrue 1
 #define ccifalse 0
 #define cciyes 1
@@ -50,6 +57,15 @@ typedef int ccibool;
 #define CCMaxMemberCount 64 
 // system support max type count
 #define CCMaxTypeCount 1000
+// the compact memory header: one word before every cc_alloc memory instead of 32 bytes
+#ifndef CCCompactMemHeader
+#define CCCompactMemHeader 0
+#endif
+// the dirty bits of members (ccobjisdirty, ccunparse_dirty): one more word of every 64 members in every object,
+// without it the objects are not tracked: nothing is dirty and ccunparse_dirty writes nothing
+#ifndef CCDirtyMembers
+#define CCDirtyMembers 0
+#endif
 // used macro
 #define cc_unused(x) (void)x 
 
@@ -68,25 +84,54 @@ ccibool cc_enablememorycache(ccibool enable);
 size_t cc_mem_size();
 // memory alloc, all memory will end with 0,  call cc_free to free
 char *cc_alloc(size_t size);
+// memory alloc without clear, only the end 0 is set, call cc_free to free
+char *cc_alloc_uninit(size_t size);
 // free memory from cc_alloc
 void cc_free(char *c);
+// the allocator backend: alloc (no need to clear), free and realloc, with the user data
+typedef void *(*ccallocfunc)(void *user, size_t size);
+typedef void (*ccfreefunc)(void *user, void *p);
+typedef void *(*ccreallocfunc)(void *user, void *p, size_t size);
+// route the new memory of library (objects, arrays, strings, cJSON nodes, type metas) to the backend,
+// realloc can be NULL, NULL alloc or free restore the malloc and free; can be switched at any time:
+// every memory records its backend and always goes back to it, so the backend should outlive its memory;
+// return ccino if there are too many (15) backends
+ccibool cc_set_allocator(ccallocfunc allocfunc, ccfreefunc freefunc, ccreallocfunc reallocfunc, void *user);
 // get the memory size
 size_t cc_len(char *c); 
 // make copy of string, and free memory with cc_free
 char *cc_dup(const char* src);
 // print the memory states
 size_t cc_mem_state();
-// print the memory states, and return the memory size hold by caches
+// the peak of memory useage total size
+size_t cc_mem_peak();
+// the count of allocs from heap and frees to heap (the memory cache hits are not counted)
+size_t cc_mem_alloccount();
+size_t cc_mem_freecount();
+// the memory cache states are the depot and the cache of this thread: every thread caches a few chunks
+// without lock, the chunks and counters of other threads are seen after they exchange a batch with the depot,
+// and all given back when thread exit
+
+// print the memory states, and return the memory size hold by caches (depot + this thread)
 size_t cc_mem_cache_state();
-// get the memory cache unit size by index 
+// get the memory cache unit size by index (depot + this thread)
 size_t cc_mem_cache_current(int index);
 // get the memory cache capacity by index
 size_t cc_mem_cache_capacity(int index);
-// set the memory capacity, set the capacity to 0 will disable the cache
+// set the memory capacity, set the capacity to 0 will disable the cache, the capacity will not adapt any more
 void cc_mem_cache_setcapacity(int index, size_t capacity); 
-// clear the memory cache of index
+// get the allocs served by the memory cache of index, the allocs it can not serve, the frees overflow to heap
+// (depot + this thread)
+size_t cc_mem_cache_hits(int index);
+size_t cc_mem_cache_misses(int index);
+size_t cc_mem_cache_overflows(int index);
+// give back the idle cached chunks and the empty slabs to system, return the bytes released
+size_t cc_mem_trim();
+// the snapshot of memory states as json (see ccmemstats, depot + this thread), need cc_free
+char *cc_mem_stats_json();
+// clear the memory cache of index (depot + this thread)
 void cc_mem_cache_clearof(int index);
-// clear all memory cache
+// clear all memory cache (depot + this thread)
 void cc_mem_cache_clear(); 
 
 
@@ -96,6 +141,48 @@ char * cc_read_file(const char* fn);
 // write content to file, content must returned from cc_alloc, cc_dup, cc_read_file
 size_t cc_write_file(char* content, const char* fn);
 
+// ******************************************************************************
+// growable buffer owned by caller, keep the capacity between calls
+typedef struct ccbuffer {
+    char *data;         // memory from cc_alloc, always end with 0
+    size_t len;         // bytes used
+    size_t capacity;    // bytes can be used (without the end 0)
+}ccbuffer;
+
+// init the buffer with capacity, capacity can be 0
+void ccbufferinit(ccbuffer *buffer, size_t capacity);
+// make sure the buffer can hold capacity bytes
+void ccbufferreserve(ccbuffer *buffer, size_t capacity);
+// append bytes to buffer
+void ccbufferappend(ccbuffer *buffer, const char *s, size_t n);
+// set the len to 0, but keep the memory
+void ccbufferclear(ccbuffer *buffer);
+// free the memory hold by buffer
+void ccbufferrelease(ccbuffer *buffer);
+
+// ******************************************************************************
+// arena owned by caller: the memory bump allocated from large blocks, released all at once
+typedef struct ccarena {
+    void *blocks;       // the blocks of blocksize, kept for reuse after reset
+    void *current;      // the block in use
+    void *large;        // the blocks of large allocs, freed by reset
+    char *cur;          // the free bytes of current block
+    char *end;
+    size_t blocksize;   // the bytes of block
+    ccibool hugepage;   // advise the blocks to be backed by huge pages
+    size_t used;        // bytes allocated since reset
+    size_t hold;        // bytes of all blocks
+}ccarena;
+
+// init the arena, blocksize can be 0 (64KB, or 2MB with hugepage)
+void ccarenainit(ccarena *arena, size_t blocksize, ccibool hugepage);
+// alloc from arena like cc_alloc (cleared, end with 0), cc_free on it does nothing
+char *ccarenaalloc(ccarena *arena, size_t size);
+// drop all the memory allocated from arena, keep the blocks for the next use
+void ccarenareset(ccarena *arena);
+// free all the blocks of arena
+void ccarenarelease(ccarena *arena);
+
 // ******************************************************************************
 // type meta infromation
 struct cctypemeta;
@@ -115,6 +202,7 @@ typedef struct cctypemeta {
     void *members;
     struct ccmembermeta **indexmembers;
     cctypemeta_init init;
+    int defaults;   // the count of members with declared default
 }cctypemeta;
 
 // member compose way: array, pointer
@@ -123,6 +211,27 @@ typedef enum enumflagcompose {
     enumflagcompose_point = 2,
 }enumflagcompose;
 
+// streaming hook of huge ccstring member, bound to the member index of meta for one call
+// (see ccparseopts and ccunparseopts); the string is never held whole in the member,
+// obj is the object holds the member
+typedef struct ccstringstream {
+    struct cctypemeta *meta;
+    int index;
+    // parse: receive the string in chunks, and (NULL, 0) at the end
+    void (*consume)(void *ud, void *obj, const char *chunk, size_t len);
+    // unserial: fill buf with the bytes start from offset, return the bytes filled, 0 means the end;
+    // may be called more than once for the same object (caculate the size, then write)
+    size_t (*produce)(void *ud, void *obj, size_t offset, char *buf, size_t cap);
+    void *ud;
+}ccstringstream;
+
+// the element filter of array member, evaluated as soon as every element parsed,
+// the rejected element is released and never take the array capacity; element is NULL for null
+typedef struct ccarrayfilter {
+    ccibool (*accept)(void *ud, void *element);
+    void *ud;
+}ccarrayfilter;
+
 // type member meta information
 typedef struct ccmembermeta {
     const char *name;
@@ -130,6 +239,11 @@ typedef struct ccmembermeta {
     int idx;        // index of member
     int offset;
     cctypemeta *type;
+    const void *defaultvalue; // the declared default value, NULL means zero of type;
+                              // applied by ccjsonobjalloc and by parse when the member is absent, without has
+    const ccarrayfilter *filter;  // the element filter of array member
+    char *key;      // the precomputed key literal: "name":
+    size_t keylen;
 }ccmembermeta;
 
 // basic json object flag 
@@ -137,8 +251,8 @@ typedef enum enumflagccjsonobj {
     enumflagccjsonobj_null = 1,
 }enumflagccjsonobj;
 
-// basic json object
-#define _ccjson_obj(n) int __index; int __flag; char __has[2*((n+7)/8)]
+// basic json object, __has: {has bits, null bits} (and dirty bits with CCDirtyMembers) of every 64 members
+#define _ccjson_obj(n) int __index; int __flag; ccuint64 __has[(2+CCDirtyMembers)*((n+63)/64)]
 
 // basic cjson_obj
 struct ccjson_obj;
@@ -163,6 +277,10 @@ size_t ccarraylen(void *array);
 int ccobjmindex(struct cctypemeta *meta, const char* member);
 // get member meta by index 
 struct ccmembermeta *ccobjmmetabyindex(struct cctypemeta *meta, int index);
+// set the element filter of array member, NULL to remove, the filter should live as long as the meta;
+// return ccino if the member is not an array
+ccibool ccsetmemberfilter(struct cctypemeta *meta, int index, const ccarrayfilter *filter);
+
 // get member count of type with the meta
 int ccobjmcount(struct cctypemeta *meta);
 
@@ -176,6 +294,22 @@ ccibool ccobjisnull(void *p, int index);
 void ccobjsetnull(void *p, int index);
 void ccobjunsetnull(void *p, int index);
 
+// dirty member (only with CCDirtyMembers): changed since last checkpoint,
+// marked by ccobjset, ccobjunset, ccobjsetnull and the typed setters (and ccobjrelease by unset)
+ccibool ccobjisdirty(void *p, int index);
+void ccobjsetdirty(void *p, int index);
+// checkpoint: clear all the dirty bits of p and sub objects
+void ccobjclean(struct cctypemeta *meta, void *p);
+
+// typed setters: set the member value and mark has, mark dirty only if the value changed,
+// return ccino if the member is not the type
+ccibool ccobjsetbool(struct cctypemeta *meta, void *p, int index, ccbool v);
+ccibool ccobjsetint(struct cctypemeta *meta, void *p, int index, ccint v);
+ccibool ccobjsetint64(struct cctypemeta *meta, void *p, int index, ccint64 v);
+ccibool ccobjsetnumber(struct cctypemeta *meta, void *p, int index, ccnumber v);
+// the string will be copied by cc_dup, and the old one freed
+ccibool ccobjsetstring(struct cctypemeta *meta, void *p, int index, const char *v);
+
 // array operator
 ccibool ccarrayhas(void *p, int index);
 void ccarrayset(void *p, int index);
@@ -236,9 +370,135 @@ void ccobjreleasearray(cctypemeta* meta, void *value);
 // serial the infromation from json , will fill all the data to value
 ccibool ccparsefrom(cctypemeta *meta, void *value, const char *json);
 
+// parse like ccparsefrom, all the strings, arrays, pointer members and scratch are allocated from arena,
+// release value by ccarenareset (or ccarenarelease) without ccobjrelease; the members set later by
+// ccobjset* are from heap and still need ccobjrelease
+ccibool ccparsefrom_arena(cctypemeta *meta, void *value, const char *json, ccarena *arena);
+
+// parse options, NULL means the same as ccparsefrom
+typedef struct ccparseopts {
+    // streaming: the string of the bound member is decoded from the json text in chunks to consume,
+    // never held whole in the cJSON tree nor in the member; the member keeps the has bit
+    const ccstringstream *streams;
+    int streamcount;
+    // accept the member index as key (see enumflagccunparse_indexkey), the digit keys are ignored if not set
+    ccibool indexkey;
+}ccparseopts;
+
+// parse like ccparsefrom with the options, the options only take effect during the call
+ccibool ccparsefrom_opts(cctypemeta *meta, void *value, const char *json, const ccparseopts *opts);
+
+// merge patch (RFC 7396) the json to value in place: the members in patch are replaced, null removes the member,
+// the object goes into the sub object recursively, all the other members and their memories are untouched
+ccibool ccpatchfrom(cctypemeta *meta, void *value, const char *json);
+
 // unserial the json object to a json string, returned string neededcall cc_free to free the memory
 char *ccunparseto(cctypemeta *meta, void *value);
 
+// unserial options flag
+typedef enum enumflagccunparse {
+    enumflagccunparse_compact = 1,  // no white spaces, same as cJSON_PrintUnformatted
+    enumflagccunparse_omitdefault = 2, // skip the members equal to default: 0, false, NULL string, empty array or the declared default
+    enumflagccunparse_indexkey = 4, // write the member index (cctypeofmindex) as key instead of name, both sides should share the same .inl;
+                                    // read back by ccparsefrom_opts with indexkey
+}enumflagccunparse;
+
+// unserial options, NULL means the same output as ccunparseto
+typedef struct ccunparseopts {
+    int flag;
+    // projection: masks[meta->index] is the member mask of the type (call ccinittypemeta to get the index),
+    // only the members in mask will be written, NULL (or index >= maskcount) means all members;
+    // the mask is words of member bits, see ccmaskset
+    const ccuint64 * const *masks;
+    int maskcount;
+    // parallel: the array member with more than chunksize elements will be split into chunks,
+    // and written on threads (include the caller), threads <= 1 means no parallel, chunksize 0 means 4096
+    int threads;
+    int chunksize;
+    // streaming: the string of the bound member (with has bit) is pulled from produce in chunks,
+    // the value in member is not used
+    const ccstringstream *streams;
+    int streamcount;
+}ccunparseopts;
+
+// helper macro: the words of member mask for member count n
+#define ccmaskwords(n) (((n)+63)/64)
+// helper macro: add member index to member mask
+#define ccmaskset(mask, index) ((mask)[(index)/64] |= ((ccuint64)1)<<((index)%64))
+// helper macro: remove member index from member mask
+#define ccmaskunset(mask, index) ((mask)[(index)/64] &= ~(((ccuint64)1)<<((index)%64)))
+
+// caculate the exact length of the json string of value (without the end 0),
+// walk the object once and without any memory alloc
+size_t ccunparse_size(cctypemeta *meta, void *value, const ccunparseopts *opts);
+
+// unserial the json object and append to buffer, return the bytes appended,
+// the buffer only grow when it is too small, so no memory alloc when reuse the buffer
+size_t ccunparse_tobuffer(cctypemeta *meta, void *value, ccbuffer *buffer, const ccunparseopts *opts);
+
+// unserial the members changed since last checkpoint (see ccobjisdirty) and append to buffer,
+// recurse into the sub objects have changes, the member unset, set null or with nothing to write is written as null,
+// then clear the dirty bits, return the bytes appended, 0 means nothing changed (always without CCDirtyMembers)
+size_t ccunparse_dirty(cctypemeta *meta, void *value, ccbuffer *buffer, const ccunparseopts *opts);
+
+// unserial the json object to out (end with 0), return the length of json string (without the end 0),
+// if the return value >= outlen the out is too small, and should call again with (return value + 1) bytes;
+// the out always ends with 0 within outlen, and holds the leading part of json text that fits
+size_t ccunparse_tofixed(cctypemeta *meta, void *value, char *out, size_t outlen, const ccunparseopts *opts);
+
+// unserial the json object to file fn directly: sized by ccunparse_size, reserved (no sparse file) and mapped once
+// (no mmap on windows, written through the buffer); sync means msync and fsync (fflush and _commit on windows)
+// before return; return the length of file, 0 means failed (the file is left empty)
+size_t ccunparse_tofile(cctypemeta *meta, void *value, const char *fn, const ccunparseopts *opts, ccibool sync);
+
+// text to text transcoder, single pass without the DOM and memory alloc, stop at len or the end 0:
+// strip white spaces and comments (same as cJSON_Minify), out need len+1 bytes and can be json (in place), return the length
+size_t ccminify(const char *json, size_t len, char *out);
+// minify and append to buffer, return the bytes appended
+size_t ccminify_tobuffer(const char *json, size_t len, ccbuffer *buffer);
+// re-indent json text like cJSON_Print, indent is the spaces of every level, 0 means tab;
+// return the length of out, if the return value >= outlen the out is too small and holds the leading part (see ccunparse_tofixed)
+size_t ccprettify(const char *json, size_t len, char *out, size_t outlen, int indent);
+// prettify and append to buffer, return the bytes appended
+size_t ccprettify_tobuffer(const char *json, size_t len, ccbuffer *buffer, int indent);
+
+// newline-delimited json writer: every object is written compact as one line into the reused buffer,
+// the buffer is flushed to file (or fd if file is NULL) only when it reaches the threshold
+typedef struct ccndjson_writer {
+    ccbuffer buffer;
+    FILE *file;
+    int fd;
+    size_t threshold;   // flush threshold in bytes, 0 means 64KB
+    ccunparseopts opts; // always with enumflagccunparse_compact
+    size_t flushed;     // bytes have been written to file or fd
+    ccibool error;      // write failed, all the later calls will fail
+}ccndjson_writer;
+
+// init the writer, opts can be NULL
+void ccndjson_writerinit(ccndjson_writer *w, FILE *file, int fd, size_t threshold, const ccunparseopts *opts);
+// write the object as one line, return ccino if write failed
+ccibool ccndjson_write(ccndjson_writer *w, cctypemeta *meta, void *value);
+// write every element of the ccarray as one line, return the lines written
+int ccndjson_writearray(ccndjson_writer *w, cctypemeta *meta, void *array);
+// write the buffered lines to file or fd
+ccibool ccndjson_flush(ccndjson_writer *w);
+// flush and free the buffer, the file or fd will not be closed
+ccibool ccndjson_writerrelease(ccndjson_writer *w);
+
+// structured log: the record declared by __cc_type_begin is written as one compact line into the buffer
+// of current thread without lock, the background thread write the full buffers and the lines left in buffers
+// to file every interval ms; threshold 0 means 64KB, interval 0 means 10ms
+ccibool cclogopen(FILE *file, size_t threshold, int interval);
+// write the record as one line
+ccibool cclogwrite(cctypemeta *meta, void *value);
+// helper macro: cclog(type, &rec)
+#define cclog(type, rec) cclogwrite(cctypeofmeta(type), rec)
+// queue the lines of current thread, the lines of exited thread are queued automaticly (not on windows)
+void cclogflush();
+// stop the background thread and write the lines of all threads, waits the lines being written by other threads;
+// the file will not be closed, the buffers of threads are kept for reopen and freed when thread exit (not on windows)
+void cclogclose();
+
 
 // ******************************************************************************
 // helper: malloc a basic json object with type meta, we can call the ccjsonobjfree to free memories
@@ -282,6 +542,7 @@ char* ccjsonobjunparseto(void *p);
 #define __ccdeclareindexmember(type, mtype, member) cctypeofmindex(type, member),
 #define __ccdeclareindexmember_array(type, mtype, member) cctypeofmindex(type, member),
 #define __ccdeclareindexmember_point(type, mtype, member) cctypeofmindex(type, member),
+#define __ccdeclareindexmember_default(type, mtype, member, value) cctypeofmindex(type, member),
 #define __ccdeclareindexend(type) cctypeofmcount(type) } __cc_index_##type ;
 
 // helper macro: declare the type meta information
@@ -333,6 +594,10 @@ char* ccjsonobjunparseto(void *p);
 #define __ccdeclaremember_point(mtype, htype, m) \
     htype* m;
 
+// helper macro: declare the complex type member with default value
+#define __ccdeclaremember_default(mtype, htype, m, value) \
+    htype m;
+
 // helper macro: end of complex type meta declare
 #define __ccdeclaretypeend(mtype) \
     } mtype; \
@@ -386,13 +651,18 @@ char* ccjsonobjunparseto(void *p);
     ccmembermeta *_member = ccmakememberwithmeta(#member, cctypeofmetaget(ntype), \
                         offsetof(mtype, member), cctypeofmindex(mtype, member), enumflagcompose_point); \
     ccaddmember(meta, _member); } while(0);
+
+// helper macro: implement the member type with default value, value is a constant of basic type
+// (the ccstring default is a string literal, cast for c++)
+#define __ccimplementmember_default(mtype, ntype, member, value)  do {\
+    static const ntype _default = (ntype)(value); \
+    ccmembermeta *_member = ccmakememberwithmeta(#member, cctypeofmetaget(ntype), \
+                        offsetof(mtype, member), cctypeofmindex(mtype, member), 0); \
+    _member->defaultvalue = &_default; \
+    ccaddmember(meta, _member); } while(0);
     
 // declare all the basic type: bool , int, number, string, int64
 // ******************************************************************************
-typedef char* ccstring;
-typedef int ccbool;
-typedef double ccnumber;
-typedef int ccint;
 
 // all basic type
 __ccdeclaretype(ccint)
@@ -418,6 +688,48 @@ __ccdeclaremember(ccconfig, ccbool, has)
 __ccdeclaremember(ccconfig, ccstring, detail)
 __ccdeclaremember_array(ccconfig, ccint, skips)
 __ccdeclaretypeend(ccconfig)
+
+// the states of memory cache size class, current/hits/misses/overflows are the depot + this thread
+__ccdeclareindexbegin(ccmemclass)
+__ccdeclareindexmember(ccmemclass, ccint, index)
+__ccdeclareindexmember(ccmemclass, ccint64, size)
+__ccdeclareindexmember(ccmemclass, ccint64, capacity)
+__ccdeclareindexmember(ccmemclass, ccint64, current)
+__ccdeclareindexmember(ccmemclass, ccint64, hits)
+__ccdeclareindexmember(ccmemclass, ccint64, misses)
+__ccdeclareindexmember(ccmemclass, ccint64, overflows)
+__ccdeclareindexmember(ccmemclass, ccint64, hold)
+__ccdeclareindexend(ccmemclass)
+
+__ccdeclaretypebegin(ccmemclass)
+__ccdeclaremember(ccmemclass, ccint, index)
+__ccdeclaremember(ccmemclass, ccint64, size)
+__ccdeclaremember(ccmemclass, ccint64, capacity)
+__ccdeclaremember(ccmemclass, ccint64, current)
+__ccdeclaremember(ccmemclass, ccint64, hits)
+__ccdeclaremember(ccmemclass, ccint64, misses)
+__ccdeclaremember(ccmemclass, ccint64, overflows)
+__ccdeclaremember(ccmemclass, ccint64, hold)
+__ccdeclaretypeend(ccmemclass)
+
+// the states of memory: the totals and every size class
+__ccdeclareindexbegin(ccmemstats)
+__ccdeclareindexmember(ccmemstats, ccint64, size)
+__ccdeclareindexmember(ccmemstats, ccint64, peak)
+__ccdeclareindexmember(ccmemstats, ccint64, alloccount)
+__ccdeclareindexmember(ccmemstats, ccint64, freecount)
+__ccdeclareindexmember(ccmemstats, ccint64, hold)
+__ccdeclareindexmember_array(ccmemstats, ccmemclass, classes)
+__ccdeclareindexend(ccmemstats)
+
+__ccdeclaretypebegin(ccmemstats)
+__ccdeclaremember(ccmemstats, ccint64, size)
+__ccdeclaremember(ccmemstats, ccint64, peak)
+__ccdeclaremember(ccmemstats, ccint64, alloccount)
+__ccdeclaremember(ccmemstats, ccint64, freecount)
+__ccdeclaremember(ccmemstats, ccint64, hold)
+__ccdeclaremember_array(ccmemstats, ccmemclass, classes)
+__ccdeclaretypeend(ccmemstats)
     
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -5,6 +5,7 @@
 #define __cc_type_member __ccimplementmember
 #define __cc_type_member_array __ccimplementmember_array
 #define __cc_type_member_point __ccimplementmember_point
+#define __cc_type_member_default __ccimplementmember_default
 #define __cc_type_end __ccimplementtypeend
 
 #include "ccjsonstruct.inl"
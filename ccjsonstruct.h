@@ -12,6 +12,7 @@ extern "C" {
 #define __cc_type_member __ccdeclareindexmember
 #define __cc_type_member_array __ccdeclareindexmember_array
 #define __cc_type_member_point __ccdeclareindexmember_point
+#define __cc_type_member_default __ccdeclareindexmember_default
 #define __cc_type_end __ccdeclareindexend
 
 #include "ccjsonstruct.inl"
@@ -20,6 +21,7 @@ extern "C" {
 #undef __cc_type_member
 #undef __cc_type_member_array
 #undef __cc_type_member_point
+#undef __cc_type_member_default
 #undef __cc_type_end
 
 // 声明类型
@@ -27,6 +29,7 @@ extern "C" {
 #define __cc_type_member __ccdeclaremember
 #define __cc_type_member_array __ccdeclaremember_array 
 #define __cc_type_member_point __ccdeclaremember_point
+#define __cc_type_member_default __ccdeclaremember_default
 #define __cc_type_end __ccdeclaretypeend
 
 #include "ccjsonstruct.inl"
@@ -35,6 +38,7 @@ extern "C" {
 #undef __cc_type_member
 #undef __cc_type_member_array
 #undef __cc_type_member_point
+#undef __cc_type_member_default
 #undef __cc_type_end
  
     
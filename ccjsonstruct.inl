@@ -2,6 +2,8 @@
  * #define __cc_type_begin(type)
  * #define __cc_type_member(type, membertype, member)
  * #define __cc_type_member_array(type, membertype, member)
+ * #define __cc_type_member_point(type, membertype, member)
+ * #define __cc_type_member_default(type, membertype, member, value)
  * #define __cc_type_end(type)
  * */
 
@@ -56,7 +58,7 @@ __cc_type_end(config_login)
 __cc_type_begin(config_splashact)
     __cc_type_member_array(config_splashact, ccstring, imgs)
     __cc_type_member(config_splashact, ccstring, jump)
-    __cc_type_member(config_splashact, ccint, secs)
+    __cc_type_member_default(config_splashact, ccint, secs, 3)
     __cc_type_member(config_splashact, config_date, date)
 __cc_type_end(config_splashact)
 
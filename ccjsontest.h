@@ -13,6 +13,10 @@
 #include "ccjsonstruct.h"
 #include "ccjson.h"
 #include <limits.h>
+#ifndef WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #define print printf 
 
@@ -401,6 +405,667 @@ SP_CASE(ccjson, ccarrayfree) {
     iccfree(array);
 }
 
+SP_CASE(ccjson, ccunparse_size) {
+    test_json *test = iccalloc(test_json);
+    const char* json = "{\"str\":\"a\\\"b\\n\\u0001\", \"i\":-12, \"i64\":-2147483648000, \"number\":0.5, \"ip\":4, \"isub\":{\"i\":3}, \"array\":[1,null,3], \"subarray\":[{\"i\":10}, null]}";
+    iccparse(test, json);
+
+    char *unjson = iccunparse(test);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(test_json), test, NULL), strlen(unjson));
+
+    ccunparseopts opts = {enumflagccunparse_compact};
+    size_t compact = ccunparse_size(cctypeofmeta(test_json), test, &opts);
+    SP_TRUE(compact < strlen(unjson));
+
+    // null object
+    ccobjnullset(test, cciyes);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(test_json), test, NULL), 4);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(test_json), NULL, NULL), 0);
+
+    iccfree(unjson);
+    iccfree(test);
+}
+
+SP_CASE(ccjson, ccunparse_tobuffer) {
+    ccconfig *config = iccalloc(ccconfig);
+    iccparse(config, "{\"ver\":1, \"has\":true, \"detail\":\"no details\", \"skips\":[1, null, 2]}");
+    char *unjson = iccunparse(config);
+    size_t len = strlen(unjson);
+
+    ccbuffer buffer;
+    ccbufferinit(&buffer, 0);
+    SP_EQUAL(ccunparse_tobuffer(cctypeofmeta(ccconfig), config, &buffer, NULL), len);
+    SP_EQUAL(strcmp(buffer.data, unjson), 0);
+
+    // reuse the buffer: append, and no more grow after clear
+    SP_EQUAL(ccunparse_tobuffer(cctypeofmeta(ccconfig), config, &buffer, NULL), len);
+    SP_EQUAL(buffer.len, 2*len);
+    char *data = buffer.data;
+    ccbufferclear(&buffer);
+    ccunparse_tobuffer(cctypeofmeta(ccconfig), config, &buffer, NULL);
+    SP_TRUE(data == buffer.data);
+    SP_EQUAL(strcmp(buffer.data, unjson), 0);
+    ccbufferappend(&buffer, NULL, 0);
+    SP_EQUAL(buffer.len, len);
+    ccbufferrelease(&buffer);
+
+    // fixed buffer: too small still ends with 0, and holds only the leading part
+    char small[8];
+    memset(small, 'x', sizeof(small));
+    SP_EQUAL(ccunparse_tofixed(cctypeofmeta(ccconfig), config, small, sizeof(small), NULL), len);
+    SP_TRUE(strlen(small) < sizeof(small));
+    SP_EQUAL(strncmp(small, unjson, strlen(small)), 0);
+    char *fixed = (char*)malloc(len + 1);
+    SP_EQUAL(ccunparse_tofixed(cctypeofmeta(ccconfig), config, fixed, len + 1, NULL), len);
+    SP_EQUAL(strcmp(fixed, unjson), 0);
+    free(fixed);
+
+    iccfree(unjson);
+    iccfree(config);
+}
+
+SP_CASE(ccjson, memberorder) {
+    ccconfig *config = iccalloc(ccconfig);
+    iccparse(config, "{\"skips\":[1, 2], \"detail\":\"d\", \"ver\":1}");
+
+    // output in declaration order, only the members that have value
+    char out[64];
+    ccunparseopts opts = {enumflagccunparse_compact};
+    ccunparse_tofixed(cctypeofmeta(ccconfig), config, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"ver\":1,\"detail\":\"d\",\"skips\":[1,2]}", out);
+
+    ccobjunset(config, cctypeofmindex(ccconfig, detail));
+    ccunparse_tofixed(cctypeofmeta(ccconfig), config, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"ver\":1,\"skips\":[1,2]}", out);
+    ccobjset(config, cctypeofmindex(ccconfig, detail));
+
+    iccrelease(config);
+    SP_TRUE(!ccobjhas(config, cctypeofmindex(ccconfig, ver)));
+    SP_TRUE(!ccobjhas(config, cctypeofmindex(ccconfig, skips)));
+    SP_TRUE(config->detail == NULL);
+    SP_TRUE(config->skips == NULL);
+
+    iccfree(config);
+}
+
+SP_CASE(ccjson, projection) {
+    config_app *app = iccalloc(config_app);
+    iccparse(app, "{\"qiniu\":true, \"hiido\":true, \"sys\":{\"referee_award\":1, \"referer_award\":2}, \"splash\":{\"secs\":3}}");
+
+    ccuint64 appmask[ccmaskwords(cctypeofmcount(config_app))] = {0};
+    ccmaskset(appmask, cctypeofmindex(config_app, qiniu));
+    ccmaskset(appmask, cctypeofmindex(config_app, sys));
+    ccuint64 sysmask[ccmaskwords(cctypeofmcount(config_sysact))] = {0};
+    ccmaskset(sysmask, cctypeofmindex(config_sysact, referer_award));
+
+    const ccuint64 *masks[CCMaxTypeCount] = {0};
+    ccinittypemeta(cctypeofmeta(config_sysact));
+    masks[cctypeofmeta(config_app)->index] = appmask;
+    masks[cctypeofmeta(config_sysact)->index] = sysmask;
+
+    ccunparseopts opts = {enumflagccunparse_compact, masks, CCMaxTypeCount};
+    char out[128];
+    ccunparse_tofixed(cctypeofmeta(config_app), app, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"qiniu\":true,\"sys\":{\"referer_award\":2}}", out);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(config_app), app, &opts), strlen(out));
+
+    // no mask of type means all members
+    masks[cctypeofmeta(config_sysact)->index] = NULL;
+    ccunparse_tofixed(cctypeofmeta(config_app), app, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"qiniu\":true,\"sys\":{\"referee_award\":1,\"referer_award\":2}}", out);
+
+    iccfree(app);
+}
+
+SP_CASE(ccjson, omitdefault) {
+    config_splashact *splash = iccalloc(config_splashact);
+    iccparse(splash, "{\"imgs\":[], \"jump\":null, \"secs\":3, \"date\":{\"validdate\":\"2015\"}}");
+
+    ccunparseopts opts = {enumflagccunparse_compact | enumflagccunparse_omitdefault, NULL, 0};
+    char out[128];
+    // secs is declared default 3
+    ccunparse_tofixed(cctypeofmeta(config_splashact), splash, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"date\":{\"validdate\":\"2015\"}}", out);
+
+    iccparse(splash, "{\"imgs\":[\"a\"], \"secs\":0}");
+    ccunparse_tofixed(cctypeofmeta(config_splashact), splash, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"imgs\":[\"a\"],\"secs\":0,\"date\":{\"validdate\":\"2015\"}}", out);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(config_splashact), splash, &opts), strlen(out));
+
+    ccconfig *config = iccalloc(ccconfig);
+    iccparse(config, "{\"ver\":0, \"ver64\":0, \"has\":false, \"detail\":\"\", \"skips\":[]}");
+    ccunparse_tofixed(cctypeofmeta(ccconfig), config, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"detail\":\"\"}", out);
+
+    iccfree(config);
+    iccfree(splash);
+
+    // the declared default applied by alloc, and by parse when absent
+    splash = iccalloc(config_splashact);
+    SP_EQUAL(splash->secs, 3);
+    SP_FALSE(ccobjhas(splash, cctypeofmindex(config_splashact, secs)));
+    iccparse(splash, "{\"imgs\":[\"a\"], \"jump\":\"j\", \"secs\":3}");
+    ccunparse_tofixed(cctypeofmeta(config_splashact), splash, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"imgs\":[\"a\"],\"jump\":\"j\"}", out);
+
+    // the output omitting defaults reads back the same
+    config_splashact back = {0};
+    SP_TRUE(ccparsefrom(cctypeofmeta(config_splashact), &back, out));
+    SP_EQUAL(back.secs, splash->secs);
+    SP_FALSE(ccobjhas(&back, cctypeofmindex(config_splashact, secs)));
+    SP_STR_EQUAL(back.jump, splash->jump);
+    SP_EQUAL(ccarraylen(back.imgs), ccarraylen(splash->imgs));
+    char fullback[128];
+    ccunparse_tofixed(cctypeofmeta(config_splashact), &back, fullback, sizeof(fullback), &opts);
+    SP_STR_EQUAL(out, fullback);
+    // the plain output has only the members read
+    ccunparse_tofixed(cctypeofmeta(config_splashact), &back, fullback, sizeof(fullback), NULL);
+    SP_TRUE(strstr(fullback, "secs") == NULL);
+
+    // explicit null is not replaced by default
+    iccparse(splash, "{\"secs\":null}");
+    SP_TRUE(ccobjisnull(splash, cctypeofmindex(config_splashact, secs)));
+    ccobjrelease(cctypeofmeta(config_splashact), &back);
+    iccfree(splash);
+}
+
+#if CCDirtyMembers
+SP_CASE(ccjson, dirty) {
+    config_app *app = iccalloc(config_app);
+    iccparse(app, "{\"qiniu\":true, \"splash\":{\"jump\":\"a\", \"secs\":3}, \"sys\":{\"referee_award\":1, \"referer_award\":2}}");
+    ccobjclean(cctypeofmeta(config_app), app);
+
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0};
+    ccbuffer buffer;
+    ccbufferinit(&buffer, 0);
+    SP_EQUAL(ccunparse_dirty(cctypeofmeta(config_app), app, &buffer, &opts), 0);
+
+    // set the same value will not mark dirty
+    SP_TRUE(ccobjsetint(cctypeofmeta(config_sysact), &app->sys, cctypeofmindex(config_sysact, referer_award), 2));
+    SP_FALSE(ccobjisdirty(&app->sys, cctypeofmindex(config_sysact, referer_award)));
+    // type mismatch
+    SP_FALSE(ccobjsetbool(cctypeofmeta(config_sysact), &app->sys, cctypeofmindex(config_sysact, referer_award), cciyes));
+
+    SP_TRUE(ccobjsetint(cctypeofmeta(config_sysact), &app->sys, cctypeofmindex(config_sysact, referer_award), 5));
+    ccunparse_dirty(cctypeofmeta(config_app), app, &buffer, &opts);
+    SP_STR_EQUAL("{\"sys\":{\"referer_award\":5}}", buffer.data);
+    // checkpoint
+    SP_EQUAL(ccunparse_dirty(cctypeofmeta(config_app), app, &buffer, &opts), 0);
+
+    ccbufferclear(&buffer);
+    ccobjsetstring(cctypeofmeta(config_splashact), &app->splash, cctypeofmindex(config_splashact, jump), "b");
+    ccobjunset(&app->splash, cctypeofmindex(config_splashact, secs));
+    ccobjsetbool(cctypeofmeta(config_app), app, cctypeofmindex(config_app, qiniu), ccino);
+    ccunparse_dirty(cctypeofmeta(config_app), app, &buffer, &opts);
+    SP_STR_EQUAL("{\"qiniu\":false,\"splash\":{\"jump\":\"b\",\"secs\":null}}", buffer.data);
+
+    // the changed member with nothing to write (the NULL pointer) is written as null
+    test_json *test = iccalloc(test_json);
+    ccobjset(test, cctypeofmindex(test_json, xsub));
+    ccbufferclear(&buffer);
+    ccunparse_dirty(cctypeofmeta(test_json), test, &buffer, &opts);
+    SP_STR_EQUAL("{\"xsub\":null}", buffer.data);
+
+    // release unsets every member
+    iccparse(test, "{\"i\":1}");
+    ccobjclean(cctypeofmeta(test_json), test);
+    ccobjrelease(cctypeofmeta(test_json), test);
+    ccbufferclear(&buffer);
+    ccunparse_dirty(cctypeofmeta(test_json), test, &buffer, &opts);
+    SP_STR_EQUAL("{\"i\":null,\"xsub\":null}", buffer.data);
+
+    ccbufferrelease(&buffer);
+    iccfree(test);
+    iccfree(app);
+}
+#else
+SP_CASE(ccjson, dirty) {
+    // no dirty bits: nothing is tracked
+    config_app *app = iccalloc(config_app);
+    iccparse(app, "{\"qiniu\":true}");
+    SP_FALSE(ccobjisdirty(app, cctypeofmindex(config_app, qiniu)));
+    ccbuffer buffer;
+    ccbufferinit(&buffer, 0);
+    SP_EQUAL(ccunparse_dirty(cctypeofmeta(config_app), app, &buffer, NULL), 0);
+    ccbufferrelease(&buffer);
+    iccfree(app);
+}
+#endif
+
+SP_CASE(ccjson, indexkey) {
+    config_app *app = iccalloc(config_app);
+    iccparse(app, "{\"qiniu\":true, \"splash\":{\"jump\":\"a\", \"secs\":4}, \"sys\":{\"referee_award\":1, \"referer_award\":2}}");
+
+    ccunparseopts opts = {enumflagccunparse_compact | enumflagccunparse_indexkey, NULL, 0};
+    char out[256];
+    ccunparse_tofixed(cctypeofmeta(config_app), app, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"1\":true,\"6\":{\"1\":\"a\",\"2\":4},\"8\":{\"0\":1,\"1\":2}}", out);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(config_app), app, &opts), strlen(out));
+
+    // the plain parse ignores the index keys
+    config_app *other = iccalloc(config_app);
+    SP_TRUE(ccparsefrom(cctypeofmeta(config_app), other, out));
+    SP_FALSE(other->qiniu);
+    SP_FALSE(ccobjhas(other, cctypeofmindex(config_app, splash)));
+
+    // parse back with the option
+    ccparseopts popts = {NULL, 0, cciyes};
+    SP_TRUE(ccparsefrom_opts(cctypeofmeta(config_app), other, out, &popts));
+    SP_TRUE(other->qiniu);
+    SP_STR_EQUAL("a", other->splash.jump);
+    SP_EQUAL(other->splash.secs, 4);
+    SP_EQUAL(other->sys.referer_award, 2);
+
+    // out of range, not a index, or leading zero
+    SP_TRUE(ccparsefrom_opts(cctypeofmeta(config_app), other, "{\"9\":{}, \"1x\":false, \"01\":false}", &popts));
+    SP_TRUE(other->qiniu);
+
+    iccfree(other);
+    iccfree(app);
+}
+
+SP_CASE(ccjson, parallelarray) {
+    char json[8192];
+    int len = sprintf(json, "{\"subarray\":[");
+    for (int i=0; i<100; ++i) {
+        len += sprintf(json + len, i == 50 ? "null," : "{\"i\":%d, \"str\":\"s%d\"},", i, i);
+    }
+    sprintf(json + len - 1, "]}");
+
+    test_json *test = iccalloc(test_json);
+    SP_TRUE(ccparsefrom(cctypeofmeta(test_json), test, json));
+
+    ccbuffer serial, parallel;
+    ccbufferinit(&serial, 0);
+    ccbufferinit(&parallel, 0);
+    for (int flag=0; flag<=enumflagccunparse_compact; ++flag) {
+        ccunparseopts opts = {flag, NULL, 0, 0, 0};
+        ccunparseopts popts = {flag, NULL, 0, 4, 7};
+        ccbufferclear(&serial);
+        ccbufferclear(&parallel);
+        ccunparse_tobuffer(cctypeofmeta(test_json), test, &serial, &opts);
+        ccunparse_tobuffer(cctypeofmeta(test_json), test, &parallel, &popts);
+        SP_STR_EQUAL(serial.data, parallel.data);
+        SP_EQUAL(ccunparse_size(cctypeofmeta(test_json), test, &popts), parallel.len);
+    }
+
+    ccbufferrelease(&serial);
+    ccbufferrelease(&parallel);
+    iccfree(test);
+}
+
+// the streaming member consume to ccbuffer, and count the chunks
+static int gstreamchunks = 0;
+static void __streamconsume(void *ud, void *obj, const char *chunk, size_t len) {
+    ccbufferappend((ccbuffer*)ud, chunk, len);
+    gstreamchunks += len ? 1 : 0;
+}
+
+// the streaming member produce from ccbuffer
+static size_t __streamproduce(void *ud, void *obj, size_t offset, char *buf, size_t cap) {
+    ccbuffer *buffer = (ccbuffer*)ud;
+    size_t n = offset < buffer->len ? buffer->len - offset : 0;
+    n = n < cap ? n : cap;
+    memcpy(buf, buffer->data + offset, n);
+    return n;
+}
+
+SP_CASE(ccjson, stringstream) {
+    ccbuffer blob;
+    ccbufferinit(&blob, 0);
+    // the hook is bound for the call only
+    ccinittypemeta(cctypeofmeta(config_imgact));
+    ccstringstream stream = {cctypeofmeta(config_imgact), cctypeofmindex(config_imgact, jump),
+        __streamconsume, __streamproduce, &blob};
+    ccparseopts popts = {&stream, 1, ccino};
+
+    // 100KB string with escapes
+    size_t len = 100*1024;
+    char *json = cc_alloc(len + 64);
+    strcpy(json, "{\"jump\":\"");
+    size_t n = strlen(json);
+    for (size_t i=0; i<len; ++i) {
+        json[n++] = (i % 1000) ? 'a' : 'b';
+    }
+    strcpy(json + n, "\\\"\", \"imgs\":[\"x\"]}");
+
+    config_imgact *img = iccalloc(config_imgact);
+    SP_TRUE(ccparsefrom_opts(cctypeofmeta(config_imgact), img, json, &popts));
+    SP_TRUE(ccobjhas(img, cctypeofmindex(config_imgact, jump)));
+    SP_TRUE(img->jump == NULL);
+    SP_EQUAL(blob.len, len+1);
+    SP_EQUAL(gstreamchunks, 2);
+    SP_EQUAL(blob.data[len], '\"');
+
+    // write back from producer
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0, &stream, 1};
+    ccbuffer out;
+    ccbufferinit(&out, 0);
+    ccunparse_tobuffer(cctypeofmeta(config_imgact), img, &out, &opts);
+    SP_EQUAL(ccunparse_size(cctypeofmeta(config_imgact), img, &opts), out.len);
+    SP_EQUAL(out.len, strlen(json) - 1);
+    SP_TRUE(strncmp(out.data, "{\"imgs\":[\"x\"],\"jump\":\"b", 23) == 0);
+    SP_TRUE(strcmp(out.data + out.len - 4, "\\\"\"}") == 0);
+
+    // without the options nothing is streamed
+    img->jump = cc_dup("j");
+    SP_TRUE(ccparsefrom(cctypeofmeta(config_imgact), img, "{\"jump\":\"k\"}"));
+    SP_STR_EQUAL(img->jump, "k");
+    SP_EQUAL(blob.len, len+1);
+
+    // the same key of other type is decoded as usual
+    config_splashact *splash = iccalloc(config_splashact);
+    SP_TRUE(ccparsefrom_opts(cctypeofmeta(config_splashact), splash, "{\"jump\":\"a\\n\\u00e9\\\"\"}", &popts));
+    SP_STR_EQUAL(splash->jump, "a\n\xc3\xa9\"");
+    SP_EQUAL(blob.len, len+1);
+    iccfree(splash);
+    ccbufferrelease(&out);
+    ccbufferrelease(&blob);
+    iccfree(img);
+    iccfree(json);
+}
+
+SP_CASE(ccjson, ccunparse_tofile) {
+    test_json *test = iccalloc(test_json);
+    // larger than one mapping step of the old writer
+    int n = 80000;
+    test->subarray = (test_json_sub*)ccarraymalloc(n, sizeof(test_json_sub), cctypeofmeta(test_json_sub)->index);
+    for (int i=0; i<n; ++i) {
+        test->subarray[i].i = i;
+        ccobjset(&test->subarray[i], cctypeofmindex(test_json_sub, i));
+        ccarrayset(test->subarray, i);
+    }
+    ccobjset(test, cctypeofmindex(test_json, subarray));
+
+    char *json = ccunparseto(cctypeofmeta(test_json), test);
+    SP_TRUE(strlen(json) > 1024*1024);
+    SP_EQUAL(ccunparse_tofile(cctypeofmeta(test_json), test, "tofile.json", NULL, cciyes), strlen(json));
+    char *content = cc_read_file("tofile.json");
+    SP_STR_EQUAL(json, content);
+    iccfree(content);
+    remove("tofile.json");
+
+    // the file can not be created
+    SP_EQUAL(ccunparse_tofile(cctypeofmeta(test_json), test, "nodir/nodir/tofile.json", NULL, ccino), 0);
+
+    iccfree(json);
+    iccfree(test);
+}
+
+SP_CASE(ccjson, transcode) {
+    test_json *test = iccalloc(test_json);
+    iccparse(test, "{\"str\":\"a \\\"b\\\" {c}\", \"i\":-12, \"number\":0.5, \"array\":[1,null,3], \"isub\":{\"i\":3}, \"subarray\":[{\"i\":10}, null]}");
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0};
+    ccbuffer compact;
+    ccbufferinit(&compact, 0);
+    ccunparse_tobuffer(cctypeofmeta(test_json), test, &compact, &opts);
+
+    // prettify the same as cJSON_Print
+    char *pretty = ccunparseto(cctypeofmeta(test_json), test);
+    char out[512];
+    SP_EQUAL(ccprettify(compact.data, compact.len, out, sizeof(out), 0), strlen(pretty));
+    SP_STR_EQUAL(pretty, out);
+    SP_EQUAL(ccprettify(compact.data, compact.len, NULL, 0, 0), strlen(pretty));
+    // too small: still end with 0, and hold only the leading part
+    char small[16];
+    SP_EQUAL(ccprettify(compact.data, compact.len, small, sizeof(small), 0), strlen(pretty));
+    SP_TRUE(strlen(small) < sizeof(small));
+    SP_EQUAL(strncmp(small, pretty, strlen(small)), 0);
+
+    // minify in place, with comments
+    sprintf(out, "/* head */ %s // tail\n", pretty);
+    SP_EQUAL(ccminify(out, strlen(out), out), compact.len);
+    SP_STR_EQUAL(compact.data, out);
+    // the empty object and the escaped backslash before quote, the same as cJSON_Print
+    test_json *empty = iccalloc(test_json);
+    iccparse(empty, "{\"str\":\"a\\\\\", \"isub\":{}, \"subarray\":[{}]}");
+    char *emptypretty = ccunparseto(cctypeofmeta(test_json), empty);
+    ccbuffer emptycompact;
+    ccbufferinit(&emptycompact, 0);
+    ccunparse_tobuffer(cctypeofmeta(test_json), empty, &emptycompact, &opts);
+    SP_EQUAL(ccprettify(emptycompact.data, emptycompact.len, out, sizeof(out), 0), strlen(emptypretty));
+    SP_STR_EQUAL(emptypretty, out);
+    ccbufferrelease(&emptycompact);
+    iccfree(emptypretty);
+    iccfree(empty);
+
+    // malformed: the stray closings never go below the top level
+    char stray[512];
+    memset(stray, '}', 300);
+    strcpy(stray + 300, "{\"a\":1}");
+    SP_EQUAL(ccprettify(stray, strlen(stray), out, sizeof(out), 0), 300 + strlen("{\n\t\"a\":\t1\n}"));
+    SP_STR_EQUAL("{\n\t\"a\":\t1\n}", out + 300);
+
+    // the comment not closed: stop at the end 0
+    const char unclosed[] = "[1] /* x\0 2";
+    SP_EQUAL(ccminify(unclosed, sizeof(unclosed)-1, out), 3);
+    SP_STR_EQUAL("[1]", out);
+
+    ccbuffer buffer;
+    ccbufferinit(&buffer, 0);
+    ccprettify_tobuffer("{\"a\":[1,2],\"b\":{}}", 18, &buffer, 2);
+    SP_STR_EQUAL("{\n  \"a\": [1, 2],\n  \"b\": {\n}\n}", buffer.data);
+    ccbufferclear(&buffer);
+    ccminify_tobuffer(pretty, strlen(pretty), &buffer);
+    SP_STR_EQUAL(compact.data, buffer.data);
+
+    ccbufferrelease(&buffer);
+    ccbufferrelease(&compact);
+    iccfree(pretty);
+    iccfree(test);
+}
+
+SP_CASE(ccjson, ndjson) {
+    test_json *test = iccalloc(test_json);
+    iccparse(test, "{\"i\":1, \"subarray\":[{\"i\":10}, null, {\"str\":\"a\"}]}");
+
+    FILE *file = tmpfile();
+    ccndjson_writer w;
+    ccndjson_writerinit(&w, file, -1, 24, NULL);
+    SP_TRUE(ccndjson_write(&w, cctypeofmeta(test_json_sub), &test->subarray[0]));
+    // below the threshold, nothing flushed
+    SP_EQUAL(w.flushed, 0);
+    SP_EQUAL(ccndjson_writearray(&w, cctypeofmeta(test_json_sub), test->subarray), 3);
+    SP_TRUE(w.flushed > 0);
+    SP_TRUE(ccndjson_writerrelease(&w));
+
+    char out[128] = {0};
+    rewind(file);
+    size_t len = fread(out, 1, sizeof(out)-1, file);
+    fclose(file);
+    SP_EQUAL(len, w.flushed);
+    SP_STR_EQUAL("{\"i\":10}\n{\"i\":10}\nnull\n{\"str\":\"a\"}\n", out);
+
+    iccfree(test);
+}
+
+#ifndef WIN32
+// log from other thread, the lines are queued when thread exit
+static void *__logthread(void *p) {
+    config_account account = {};
+    ccparsefrom(cctypeofmeta(config_account), &account, "{\"accounttype\":2, \"name\":\"thread\"}");
+    for (int i=0; i<100; ++i) {
+        cclog(config_account, &account);
+    }
+    ccobjrelease(cctypeofmeta(config_account), &account);
+    return NULL;
+}
+
+// log from other thread, and keep alive until the log closed: the lines are written when close
+static void *__logalivethread(void *p) {
+    int *fds = (int*)p;
+    char c = 0;
+    config_account account = {};
+    ccparsefrom(cctypeofmeta(config_account), &account, "{\"accounttype\":2, \"name\":\"thread\"}");
+    for (int i=0; i<3; ++i) {
+        cclog(config_account, &account);
+    }
+    ccobjrelease(cctypeofmeta(config_account), &account);
+    write(fds[1], &c, 1);
+    read(fds[2], &c, 1);
+    return NULL;
+}
+#endif
+
+SP_CASE(ccjson, cclog) {
+    FILE *file = tmpfile();
+    SP_TRUE(cclogopen(file, 256, 1));
+    SP_FALSE(cclogopen(file, 256, 1));
+
+    config_account account = {};
+    ccparsefrom(cctypeofmeta(config_account), &account, "{\"accounttype\":1, \"name\":\"a\\nb\", \"state\":0}");
+    for (int i=0; i<1000; ++i) {
+        account.state = i;
+        SP_TRUE(cclog(config_account, &account));
+    }
+    int lines = 1000;
+#ifndef WIN32
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, __logthread, NULL) == 0) {
+        pthread_join(thread, NULL);
+        lines += 100;
+    }
+    // the thread tells logged by fds[1], and waits the close by fds[2]
+    int fds[4];
+    pthread_t alive;
+    SP_EQUAL(pipe(fds), 0);
+    SP_EQUAL(pipe(fds+2), 0);
+    ccibool started = pthread_create(&alive, NULL, __logalivethread, fds) == 0;
+    if (started) {
+        char c;
+        read(fds[0], &c, 1);
+        lines += 3;
+    }
+#endif
+    cclogclose();
+    SP_FALSE(cclog(config_account, &account));
+#ifndef WIN32
+    if (started) {
+        write(fds[3], "", 1);
+        pthread_join(alive, NULL);
+    }
+    for (int i=0; i<4; ++i) {
+        close(fds[i]);
+    }
+#endif
+
+    // every record is one line
+    char line[256];
+    int count = 0, threads = 0;
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        if (strcmp(line, "{\"accounttype\":2,\"name\":\"thread\"}\n") == 0) {
+            ++threads;
+        } else if (count - threads < 2) {
+            char expect[128];
+            sprintf(expect, "{\"accounttype\":1,\"name\":\"a\\nb\",\"state\":%d}\n", count - threads);
+            SP_STR_EQUAL(expect, line);
+        }
+        ++count;
+    }
+    fclose(file);
+    SP_EQUAL(count, lines);
+
+#ifndef WIN32
+    // the quiet thread: the lines below threshold are written in interval without flush
+    file = fopen("cclog.log", "wb");
+    SP_TRUE(cclogopen(file, 0, 1));
+    SP_TRUE(cclog(config_account, &account));
+    long size = 0;
+    for (int i=0; i<1000 && size == 0; ++i) {
+        usleep(1000);
+        FILE *reader = fopen("cclog.log", "rb");
+        fseek(reader, 0, SEEK_END);
+        size = ftell(reader);
+        fclose(reader);
+    }
+    SP_TRUE(size > 0);
+    cclogclose();
+    fclose(file);
+    remove("cclog.log");
+#endif
+
+    ccobjrelease(cctypeofmeta(config_account), &account);
+}
+
+SP_CASE(ccjson, ccpatchfrom) {
+    config_app *app = iccalloc(config_app);
+    iccparse(app, "{\"qiniu\":true, \"splash\":{\"imgs\":[\"a\"], \"jump\":\"j\", \"secs\":4}, \"sys\":{\"referee_award\":1}}");
+    char *jump = app->splash.jump;
+    ccstring *imgs = app->splash.imgs;
+
+    SP_TRUE(ccpatchfrom(cctypeofmeta(config_app), app,
+        "{\"splash\":{\"secs\":9, \"date\":{\"validdate\":\"v\"}}, \"sys\":null, \"ym\":true, \"unknown\":1}"));
+    // untouched members keep the memories
+    SP_TRUE(app->splash.jump == jump);
+    SP_TRUE(app->splash.imgs == imgs);
+    SP_EQUAL(app->splash.secs, 9);
+    SP_FALSE(ccobjhas(app, cctypeofmindex(config_app, sys)));
+    SP_FALSE(ccobjisnull(app, cctypeofmindex(config_app, sys)));
+
+    ccunparseopts opts = {enumflagccunparse_compact, NULL, 0, 0, 0};
+    char out[256];
+    ccunparse_tofixed(cctypeofmeta(config_app), app, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"qiniu\":true,\"ym\":true,\"splash\":{\"imgs\":[\"a\"],\"jump\":\"j\",\"secs\":9,\"date\":{\"validdate\":\"v\"}}}", out);
+
+    // arrays and strings are replaced
+    SP_TRUE(ccpatchfrom(cctypeofmeta(config_app), app, "{\"splash\":{\"imgs\":[\"b\", \"c\"], \"jump\":null}}"));
+    ccunparse_tofixed(cctypeofmeta(config_app), app, out, sizeof(out), &opts);
+    SP_STR_EQUAL("{\"qiniu\":true,\"ym\":true,\"splash\":{\"imgs\":[\"b\",\"c\"],\"secs\":9,\"date\":{\"validdate\":\"v\"}}}", out);
+    SP_TRUE(app->splash.jump == NULL);
+
+    SP_FALSE(ccpatchfrom(cctypeofmeta(config_app), app, "{bad"));
+    iccfree(app);
+
+    // null on the absent object and array members does nothing
+    ccinittypemeta(cctypeofmeta(test_json_sub));
+    test_json *t = iccalloc(test_json);
+    SP_TRUE(ccpatchfrom(cctypeofmeta(test_json), t, "{\"xsub\":null, \"subarray\":null, \"array\":null}"));
+    SP_TRUE(t->xsub == NULL);
+    SP_TRUE(t->subarray == NULL);
+    SP_FALSE(ccobjhas(t, cctypeofmindex(test_json, xsub)));
+    SP_FALSE(ccobjhas(t, cctypeofmindex(test_json, array)));
+    iccfree(t);
+}
+
+// keep the account with state == 1
+static ccibool __accountfilter(void *ud, void *element) {
+    config_account *account = (config_account*)element;
+    ++*(int*)ud;
+    return account && account->state == 1;
+}
+
+SP_CASE(ccjson, arrayfilter) {
+    int count = 0;
+    ccarrayfilter filter = {__accountfilter, &count};
+    SP_FALSE(ccsetmemberfilter(cctypeofmeta(config_account), cctypeofmindex(config_account, name), &filter));
+    SP_TRUE(ccsetmemberfilter(cctypeofmeta(config_login), cctypeofmindex(config_login, accounttypes), &filter));
+
+    config_login *login = iccalloc(config_login);
+    iccparse(login, "{\"accounttypes\":[{\"name\":\"a\", \"state\":0}, {\"name\":\"b\", \"state\":1}, null,"
+             " {\"name\":\"c\", \"state\":2}, {\"name\":\"d\", \"state\":1}]}");
+    SP_EQUAL(count, 5);
+    SP_EQUAL(ccarraylen(login->accounttypes), 2);
+    SP_STR_EQUAL("b", login->accounttypes[0].name);
+    SP_STR_EQUAL("d", login->accounttypes[1].name);
+    SP_TRUE(ccarrayhas(login->accounttypes, 1));
+
+    // all rejected
+    iccparse(login, "{\"accounttypes\":[{\"name\":\"a\", \"state\":0}]}");
+    SP_EQUAL(ccarraylen(login->accounttypes), 0);
+
+    // the element not parsed is never asked, and kept unset as no filter
+    count = 0;
+    iccparse(login, "{\"accounttypes\":[{\"name\":\"b\", \"state\":1}, \"s\"]}");
+    SP_EQUAL(count, 1);
+    SP_EQUAL(ccarraylen(login->accounttypes), 2);
+    SP_TRUE(ccarrayhas(login->accounttypes, 0));
+    SP_FALSE(ccarrayhas(login->accounttypes, 1));
+
+    ccsetmemberfilter(cctypeofmeta(config_login), cctypeofmindex(config_login, accounttypes), NULL);
+    iccfree(login);
+}
+
 SP_CASE(ccjson, cc_mem_cache) {
     cc_enablememorycache(cciyes);
     cc_mem_cache_clear();
@@ -446,6 +1111,436 @@ SP_CASE(ccjson, cc_mem_cache) {
     SP_TRUE(1);
 }
 
+#ifndef WIN32
+// alloc and free on thread, and keep some to be freed by others
+static void *__memthread(void *p) {
+    char **keeps = (char**)p;
+    for (int i=0; i<10000; ++i) {
+        char *c = cc_alloc(i % 300 + 1);
+        c[0] = 'a';
+        cc_free(c);
+    }
+    for (int i=0; i<100; ++i) {
+        keeps[i] = cc_alloc(i + 1);
+    }
+    return NULL;
+}
+#endif
+
+SP_CASE(ccjson, cc_mem_cache_threads) {
+#ifndef WIN32
+    cc_enablememorycache(cciyes);
+    cc_mem_cache_clear();
+    size_t hold = cc_mem_size();
+
+    pthread_t threads[4];
+    char *keeps[4][100];
+    for (int i=0; i<4; ++i) {
+        pthread_create(&threads[i], NULL, __memthread, keeps[i]);
+    }
+    for (int i=0; i<4; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    // free on the other thread
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<100; ++j) {
+            cc_free(keeps[i][j]);
+        }
+    }
+    // the exited threads give back the caches to depot
+    cc_mem_cache_clear();
+    SP_EQUAL(cc_mem_size(), hold);
+#endif
+}
+
+SP_CASE(ccjson, cc_mem_stats) {
+    size_t hold = cc_mem_size();
+    size_t alloccount = cc_mem_alloccount();
+    size_t freecount = cc_mem_freecount();
+
+    // beyond the memory cache, always from heap
+    char *c = cc_alloc(1024*1024);
+    SP_EQUAL(cc_mem_alloccount(), alloccount + 1);
+    SP_TRUE(cc_mem_size() > hold + 1024*1024);
+    SP_TRUE(cc_mem_peak() >= cc_mem_size());
+    size_t peak = cc_mem_peak();
+
+    cc_free(c);
+    SP_EQUAL(cc_mem_freecount(), freecount + 1);
+    SP_EQUAL(cc_mem_size(), hold);
+    SP_EQUAL(cc_mem_peak(), peak);
+}
+
+SP_CASE(ccjson, cc_mem_slab) {
+    cc_enablememorycache(cciyes);
+    cc_mem_cache_clear();
+    size_t hold = cc_mem_size();
+    size_t alloccount = cc_mem_alloccount();
+
+    // the small chunks are split from 64KB slabs
+    char *alls[1000];
+    for (int i=0; i<1000; ++i) {
+        alls[i] = cc_alloc(16);
+        SP_EQUAL(alls[i][15], 0);
+        memset(alls[i], 'a', 16);
+    }
+    SP_TRUE(cc_mem_alloccount() - alloccount < 10);
+    // the neighbors are in the same slab
+    SP_TRUE(alls[1] - alls[0] == alls[2] - alls[1]);
+
+    // free to heap with memory cache disabled, the chunk go back to slab
+    cc_enablememorycache(ccino);
+    cc_free(alls[0]);
+    cc_enablememorycache(cciyes);
+    for (int i=1; i<1000; ++i) {
+        cc_free(alls[i]);
+    }
+    // all the slabs are empty and go back to system
+    cc_mem_cache_clear();
+    SP_EQUAL(cc_mem_size(), hold);
+}
+
+SP_CASE(ccjson, cc_mem_class) {
+    cc_enablememorycache(cciyes);
+
+    // four size classes in every power of two, no more than 25% waste
+    size_t pre = 0;
+    for (size_t size=1; size<=32768; ++size) {
+        char *c = cc_alloc(size);
+        size_t len = cc_len(c);
+        SP_TRUE(len >= size);
+        SP_TRUE(size <= 16 ? len - size < 4 : len - size < size/4 + 1);
+        SP_TRUE(len >= pre);
+        pre = len;
+        cc_free(c);
+    }
+    SP_EQUAL(pre, 32768);
+    char *c = cc_alloc(9);
+    SP_EQUAL(cc_len(c), 12);
+    cc_free(c);
+
+    // beyond the last class go to heap directly
+    c = cc_alloc(32769);
+    SP_EQUAL(cc_len(c), 32769);
+    cc_free(c);
+    cc_mem_cache_clear();
+}
+
+SP_CASE(ccjson, cc_mem_header) {
+    // the header bytes before memory from heap
+    cc_enablememorycache(ccino);
+    size_t hold = cc_mem_size();
+    char *c = cc_alloc(100);
+    SP_EQUAL(cc_len(c), 100);
+    SP_EQUAL(cc_mem_size() - hold, (CCCompactMemHeader ? sizeof(size_t) : 4*sizeof(void*)) + 101);
+    cc_free(c);
+    SP_EQUAL(cc_mem_size(), hold);
+    cc_enablememorycache(cciyes);
+
+    // the freed memory hold the link of cache, and is clean when alloc again
+    char *s = cc_alloc(4);
+    memset(s, 'a', 4);
+    cc_free(s);
+    s = cc_alloc(4);
+    SP_EQUAL(cc_len(s), 4);
+    SP_EQUAL(memcmp(s, "\0\0\0\0\0", 5), 0);
+    cc_free(s);
+
+    // the flags of object and array
+    config_app *app = iccalloc(config_app);
+    int *arr = (int*)ccarraymalloc(10, sizeof(int), 0);
+    SP_TRUE(cc_len((char*)app) >= sizeof(config_app));
+    iccfree(arr);
+    iccfree(app);
+    cc_mem_cache_clear();
+}
+
+SP_CASE(ccjson, cc_alloc_uninit) {
+    cc_enablememorycache(cciyes);
+    char *c = cc_alloc(64);
+    memset(c, 'a', 64);
+    cc_free(c);
+
+    // the memory from cache is not cleared, but end with 0
+    char *u = cc_alloc_uninit(60);
+    SP_EQUAL(cc_len(u), 64);
+    SP_EQUAL(u[60], 0);
+    memset(u, 'b', 60);
+    SP_EQUAL(strlen(u), 60);
+    cc_free(u);
+
+    // from heap
+    u = cc_alloc_uninit(40000);
+    SP_EQUAL(cc_len(u), 40000);
+    SP_EQUAL(u[40000], 0);
+    cc_free(u);
+
+    // the strings and arrays of parse still right
+    char *d = cc_dup("abc");
+    SP_EQUAL(strcmp(d, "abc"), 0);
+    cc_free(d);
+    ccconfig *config = iccalloc(ccconfig);
+    SP_TRUE(iccparse(config, "{\"skips\":[1, \"x\", 3]}"));
+    SP_EQUAL(ccarraylen(config->skips), 3);
+    SP_EQUAL(config->skips[1], 0);
+    SP_EQUAL(config->skips[2], 3);
+    iccfree(config);
+    cc_mem_cache_clear();
+}
+
+SP_CASE(ccjson, cc_mem_adapt) {
+    cc_enablememorycache(cciyes);
+    // the class of 3072 bytes
+    const int index = 33;
+    char *c = cc_alloc(3000);
+    SP_EQUAL(cc_len(c), 3072);
+    cc_free(c);
+    size_t hits = cc_mem_cache_hits(index);
+    size_t misses = cc_mem_cache_misses(index);
+    size_t overflows = cc_mem_cache_overflows(index);
+    SP_EQUAL(cc_mem_cache_capacity(index), 100);
+
+    // the burst larger than the capacity: the capacity grows
+    char *alls[400];
+    for (int round=0; round<4; ++round) {
+        for (int i=0; i<400; ++i) {
+            alls[i] = cc_alloc(3000);
+        }
+        for (int i=0; i<400; ++i) {
+            cc_free(alls[i]);
+        }
+    }
+    SP_TRUE(cc_mem_cache_hits(index) > hits);
+    SP_TRUE(cc_mem_cache_misses(index) > misses);
+    SP_TRUE(cc_mem_cache_overflows(index) > overflows);
+    SP_TRUE(cc_mem_cache_capacity(index) > 100);
+
+    // the idle chunks go back to system after traffic, and the capacity shrinks
+    size_t current = cc_mem_cache_current(index);
+    cc_mem_trim();
+    SP_TRUE(cc_mem_trim() > 0);
+    SP_TRUE(cc_mem_cache_current(index) < current);
+    SP_TRUE(cc_mem_cache_capacity(index) < 400);
+
+    // the capacity set by caller is not adapted
+    cc_mem_cache_setcapacity(index, 100);
+    for (int i=0; i<400; ++i) {
+        alls[i] = cc_alloc(3000);
+    }
+    for (int i=0; i<400; ++i) {
+        cc_free(alls[i]);
+    }
+    SP_EQUAL(cc_mem_cache_capacity(index), 100);
+    cc_mem_cache_clear();
+}
+
+SP_CASE(ccjson, cc_mem_stats_json) {
+    cc_enablememorycache(cciyes);
+    cc_free(cc_mem_stats_json());
+    char *c = cc_alloc(100);
+    size_t size = cc_len(c);
+    cc_free(c);
+
+    // the snapshot can be parsed back by ccjson
+    char *json = cc_mem_stats_json();
+    SP_TRUE(json != NULL);
+    ccmemstats *stats = iccalloc(ccmemstats);
+    SP_TRUE(iccparse(stats, json));
+    SP_TRUE(stats->size > 0);
+    SP_TRUE(stats->peak >= stats->size);
+    SP_TRUE(stats->alloccount > 0);
+    SP_TRUE(ccarraylen(stats->classes) > 1);
+    SP_EQUAL(stats->classes[0].size, 4);
+
+    // the class of 100 bytes holds the chunk freed
+    ccint64 hold = 0;
+    ccmemclass *hit = NULL;
+    for (size_t i=0; i<ccarraylen(stats->classes); ++i) {
+        ccmemclass *cls = &stats->classes[i];
+        SP_EQUAL(cls->index, (int)i);
+        SP_EQUAL(cls->hold, cls->current * cls->size);
+        hold += cls->hold;
+        if (cls->size == (ccint64)size) {
+            hit = cls;
+        }
+    }
+    SP_EQUAL(stats->hold, hold);
+    SP_TRUE(hit && hit->current > 0);
+    iccfree(stats);
+    cc_free(json);
+    cc_mem_cache_clear();
+}
+
+// the bump pool backend: every block keeps its size before it, free of memory not in pool is counted
+typedef struct cctestpool {
+    char *base;
+    size_t capacity;
+    size_t used;
+    size_t allocs;
+    size_t frees;
+    size_t foreign;
+}cctestpool;
+
+static void *__cctestpoolalloc(void *user, size_t size) {
+    cctestpool *pool = (cctestpool*)user;
+    size_t bytes = (16 + size + 15) & ~(size_t)15;
+    char *p;
+    if (pool->used + bytes > pool->capacity) {
+        return NULL;
+    }
+    p = pool->base + pool->used;
+    pool->used += bytes;
+    ++pool->allocs;
+    *(size_t*)p = size;
+    return p + 16;
+}
+
+static void __cctestpoolfree(void *user, void *p) {
+    cctestpool *pool = (cctestpool*)user;
+    if ((char*)p < pool->base || (char*)p >= pool->base + pool->capacity) {
+        ++pool->foreign;
+        return;
+    }
+    ++pool->frees;
+}
+
+SP_CASE(ccjson, cc_set_allocator) {
+    // the backend stays registered with the pool, so the pool outlives the case
+    static cctestpool pool = {NULL, 16*1024*1024, 0, 0, 0, 0};
+    pool.base = (char*)malloc(pool.capacity);
+    cc_enablememorycache(cciyes);
+
+    // the memory alloced before the backend set, from the heap and the slabs
+    ccconfig *before = iccalloc(ccconfig);
+    SP_TRUE(iccparse(before, "{\"ver\":1, \"detail\":\"before\", \"skips\":[1,2,3]}"));
+    ccbuffer grown;
+    ccbufferinit(&grown, 40000);
+
+    // the backend without realloc
+    SP_TRUE(cc_set_allocator(__cctestpoolalloc, __cctestpoolfree, NULL, &pool));
+
+    // the cJSON nodes, the objects and the strings all go to the backend
+    ccconfig *config = iccalloc(ccconfig);
+    SP_TRUE(iccparse(config, "{\"ver\":2, \"detail\":\"abcdefg\", \"skips\":[1,2,3]}"));
+    SP_EQUAL(strcmp(config->detail, "abcdefg"), 0);
+    SP_TRUE(pool.allocs > 0);
+    SP_TRUE(pool.frees > 0);
+
+    // the large buffer grows by the backend copy, and the block from malloc grows by realloc
+    ccbuffer buffer;
+    ccbufferinit(&buffer, 0);
+    char block[1024];
+    memset(block, 'a', sizeof(block));
+    for (int i=0; i<256; ++i) {
+        ccbufferappend(&buffer, block, sizeof(block));
+        ccbufferappend(&grown, block, sizeof(block));
+    }
+    SP_EQUAL(buffer.len, 256*1024);
+    SP_EQUAL(buffer.data[buffer.len-1], 'a');
+    SP_EQUAL(buffer.data[buffer.len], 0);
+    SP_TRUE(buffer.data > pool.base && buffer.data < pool.base + pool.capacity);
+    SP_FALSE(grown.data > pool.base && grown.data < pool.base + pool.capacity);
+    SP_EQUAL(grown.len, 256*1024);
+
+    // the memory before goes back to malloc
+    iccfree(before);
+    ccbufferrelease(&grown);
+    SP_EQUAL(pool.foreign, 0);
+
+    // switch back, the memory of pool still goes back to pool
+    SP_TRUE(cc_set_allocator(NULL, NULL, NULL, NULL));
+    size_t allocs = pool.allocs;
+    size_t frees = pool.frees;
+    char *c = cc_alloc(40000);
+    cc_free(c);
+    SP_EQUAL(pool.allocs, allocs);
+    iccfree(config);
+    ccbufferrelease(&buffer);
+    cc_mem_cache_clear();
+    SP_TRUE(pool.frees > frees);
+    SP_EQUAL(pool.foreign, 0);
+
+    // the same backend keeps the owner
+    SP_TRUE(cc_set_allocator(__cctestpoolalloc, __cctestpoolfree, NULL, &pool));
+    // the full backend: the alloc fails with NULL
+    SP_TRUE(cc_alloc(pool.capacity) == NULL);
+    SP_TRUE(cc_set_allocator(NULL, NULL, NULL, NULL));
+
+    // all the memory of pool have been given back, after the caches drained
+    cc_mem_cache_clear();
+    SP_EQUAL(pool.frees, pool.allocs);
+    free(pool.base);
+    pool.base = NULL;
+}
+
+SP_CASE(ccjson, ccparsefrom_arena) {
+    const char *json = "{\"login\":{\"accounttypes\":[{\"accounttype\":1, \"name\":\"qq\", \"state\":1},"
+        " {\"accounttype\":2, \"name\":\"weixin\", \"state\":0}]}, \"qiniu\":true, \"ym\":false,"
+        " \"splash\":{\"imgs\":[\"a.png\", \"b.png\"], \"jump\":\"http://j\", \"secs\":5,"
+        " \"date\":{\"invaliddate\":\"2017-01-01\", \"validdate\":\"2016-01-01\"}},"
+        " \"reg\":{\"imgs\":[{\"imgs\":[\"r.png\"], \"jump\":\"http://r\"}]},"
+        " \"sys\":{\"referee_award\":10, \"referer_award\":20}}";
+    config_app heap = {0};
+    SP_TRUE(ccparsefrom(cctypeofmeta(config_app), &heap, json));
+    char *expect = ccunparseto(cctypeofmeta(config_app), &heap);
+
+    ccarena arena;
+    ccarenainit(&arena, 0, ccino);
+    size_t hold = cc_mem_size();
+    for (int round=0; round<3; ++round) {
+        config_app app = {0};
+        SP_TRUE(ccparsefrom_arena(cctypeofmeta(config_app), &app, json, &arena));
+        SP_TRUE(arena.used > 0);
+        char *out = ccunparseto(cctypeofmeta(config_app), &app);
+        SP_EQUAL(strcmp(out, expect), 0);
+        cc_free(out);
+        // free the arena memory does nothing
+        ccobjrelease(cctypeofmeta(config_app), &app);
+        // the blocks are kept and reused by next round
+        size_t blocks = arena.hold;
+        ccarenareset(&arena);
+        SP_EQUAL(arena.used, 0);
+        SP_EQUAL(arena.hold, blocks);
+        SP_EQUAL(cc_mem_size() - hold, blocks);
+    }
+
+    // the large array get a block of its own, freed by reset
+    ccconfig config;
+    memset(&config, 0, sizeof(config));
+    ccbuffer buffer;
+    ccbufferinit(&buffer, 0);
+    ccbufferappend(&buffer, "{\"skips\":[0", 11);
+    for (int i=1; i<20000; ++i) {
+        ccbufferappend(&buffer, ",1", 2);
+    }
+    ccbufferappend(&buffer, "]}", 2);
+    size_t blocks = arena.hold;
+    SP_TRUE(ccparsefrom_arena(cctypeofmeta(ccconfig), &config, buffer.data, &arena));
+    SP_EQUAL(ccarraylen(config.skips), 20000);
+    SP_EQUAL(config.skips[19999], 1);
+    SP_TRUE(arena.hold > blocks + 20000*sizeof(ccint));
+    ccarenareset(&arena);
+    SP_EQUAL(arena.hold, blocks);
+    ccbufferrelease(&buffer);
+
+    hold = cc_mem_size() - arena.hold;
+    ccarenarelease(&arena);
+    SP_EQUAL(arena.hold, 0);
+    SP_EQUAL(cc_mem_size(), hold);
+
+    // the huge pages
+    ccarenainit(&arena, 0, cciyes);
+    config_app app = {0};
+    SP_TRUE(ccparsefrom_arena(cctypeofmeta(config_app), &app, json, &arena));
+    char *out = ccunparseto(cctypeofmeta(config_app), &app);
+    SP_EQUAL(strcmp(out, expect), 0);
+    cc_free(out);
+    ccarenarelease(&arena);
+
+    cc_free(expect);
+    ccobjrelease(cctypeofmeta(config_app), &heap);
+}
+
 SP_CASE(ccjson, benchmarktestcomplex) {
     config_app *app = iccalloc(config_app);
     char *json = cc_read_file("app.json");